@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    Benchmarks.cpp
+
+    Times the audio thread's heavier kernels a block at a time, on their own, so
+    changes to them can be compared. Run with a name, or part of one, to time only
+    the benchmarks that match. Build in Release; debug timings mean nothing.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "IsolatorEQ.h"
+#include "MemoryAudioSource.h"
+#include "Resampler.h"
+#include "SampleStorage.h"
+#include "TimeStretcher.h"
+
+using namespace OtoDecksAudio;
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+
+    // Blocks timed per benchmark, after a few untimed ones to warm the caches
+    constexpr int numBlocks = 20000;
+    constexpr int numWarmUpBlocks = 200;
+
+    // Runs processBlock over and over and reports its average cost per block, against
+    // the time a block lasts at the device rate
+    template <typename ProcessBlock>
+    void timeBlocks(const juce::String& name, ProcessBlock&& processBlock)
+    {
+        for (int i = 0; i < numWarmUpBlocks; ++i)
+            processBlock(i);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+            processBlock(i);
+
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        const double microsecondsPerBlock = seconds * 1.0e6 / numBlocks;
+        const double blockMicroseconds = blockSize * 1.0e6 / sampleRate;
+
+        std::cout << name.paddedRight(' ', 36)
+                  << juce::String(microsecondsPerBlock, 2).paddedLeft(' ', 9) << " us/block"
+                  << juce::String(100.0 * microsecondsPerBlock / blockMicroseconds, 3).paddedLeft(' ', 9) << " %"
+                  << juce::String(blockMicroseconds / microsecondsPerBlock, 0).paddedLeft(' ', 8) << "x real time"
+                  << std::endl;
+    }
+
+    // A few seconds of two detuned sines, louder than silence and not periodic in a block
+    std::vector<float> makeSignal(int numSamples)
+    {
+        std::vector<float> signal((size_t)numSamples);
+
+        for (size_t i = 0; i < signal.size(); ++i)
+            signal[i] = 0.4f * (float)std::sin(0.0571 * (double)i) + 0.3f * (float)std::sin(0.2113 * (double)i);
+
+        return signal;
+    }
+
+    // A stereo track long enough that a block's reads miss the cache, as a deck's do
+    void makeTrack(SampleStorage& storage, SampleStorage::Format format)
+    {
+        const auto signal = makeSignal((int)(30.0 * sampleRate));
+
+        storage.setSize(format, 2, (juce::int64)signal.size());
+
+        for (int channel = 0; channel < 2; ++channel)
+            storage.write(channel, 0, signal.data(), (int)signal.size());
+    }
+
+    //==============================================================================
+    // One channel of a block read at each speed, through each quality tier
+    void benchmarkResampler()
+    {
+        Resampler::prepare();
+
+        const std::pair<Resampler::Quality, const char*> qualities[] = {
+            { Resampler::Quality::Linear, "linear" },
+            { Resampler::Quality::Cubic, "cubic" },
+            { Resampler::Quality::Sinc, "sinc" }
+        };
+
+        std::vector<float> output((size_t)blockSize);
+
+        for (const auto& [quality, qualityName] : qualities)
+        {
+            for (const double increment : { 0.94, 1.3, 2.0 })
+            {
+                const int before = Resampler::getSamplesBefore(quality, increment);
+                const int after = Resampler::getSamplesAfter(quality, increment);
+                const auto source = makeSignal(before + (int)std::ceil(blockSize * increment) + after + 1);
+
+                timeBlocks("resampler " + juce::String(qualityName) + " " + juce::String(increment, 2) + "x",
+                           [&](int)
+                           {
+                               Resampler::process(quality, source.data(), output.data(), blockSize,
+                                                  (double)before + 0.37, increment, 0.0);
+                           });
+            }
+        }
+    }
+
+    //==============================================================================
+    // Both channels of a block converted back to float from each storage format, walking
+    // through the track as playback would, and the memory the track takes in each
+    void benchmarkSampleStorage()
+    {
+        const std::pair<SampleStorage::Format, const char*> formats[] = {
+            { SampleStorage::Format::Float32, "float32" },
+            { SampleStorage::Format::Int16, "int16" },
+            { SampleStorage::Format::Float16, "float16" }
+        };
+
+        juce::AudioBuffer<float> output(2, blockSize);
+
+        for (const auto& [format, formatName] : formats)
+        {
+            SampleStorage storage;
+            makeTrack(storage, format);
+
+            std::cout << ("sample storage size " + juce::String(formatName)).paddedRight(' ', 36)
+                      << juce::String((double)storage.getSizeInBytes() / (1024.0 * 1024.0), 2).paddedLeft(' ', 9)
+                      << " MB for 30 s stereo" << std::endl;
+
+            const juce::int64 numBlocksInTrack = storage.getNumSamples() / blockSize;
+
+            timeBlocks("sample storage read " + juce::String(formatName), [&](int block)
+            {
+                const juce::int64 start = (block % numBlocksInTrack) * blockSize;
+
+                for (int channel = 0; channel < 2; ++channel)
+                    storage.read(channel, start, output.getWritePointer(channel), blockSize, 0.8f);
+            });
+        }
+    }
+
+    //==============================================================================
+    // A deck's stereo block at 1x, which is copied run by run straight from the track,
+    // against the sample-at-a-time loop it replaced as a reference
+    void benchmarkMemorySource()
+    {
+        SampleStorage storage;
+        makeTrack(storage, SampleStorage::Format::Float32);
+
+        juce::AudioBuffer<float> stereo(2, blockSize), mono(1, blockSize);
+
+        {
+            // The old source kept the track in an AudioBuffer and checked for its end on every sample
+            const auto signal = makeSignal((int)storage.getNumSamples());
+            juce::AudioBuffer<float> track(2, (int)signal.size());
+
+            for (int channel = 0; channel < 2; ++channel)
+                track.copyFrom(channel, 0, signal.data(), (int)signal.size());
+
+            int position = 0;
+
+            timeBlocks("memory source per-sample reference", [&](int)
+            {
+                const int start = position;
+
+                for (int channel = 0; channel < stereo.getNumChannels(); ++channel)
+                {
+                    float* writePtr = stereo.getWritePointer(channel);
+                    position = start;
+
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        if (position >= track.getNumSamples())
+                            position = 0;
+
+                        writePtr[i] = track.getSample(channel % track.getNumChannels(), position);
+                        ++position;
+                    }
+                }
+            });
+        }
+
+        for (const bool backwards : { false, true })
+        {
+            MemoryAudioSource source(storage, true);
+            source.prepareToPlay(blockSize, sampleRate);
+            source.setReversed(backwards);
+
+            const juce::String direction = backwards ? "backwards" : "forwards";
+
+            timeBlocks("memory source stereo " + direction, [&](int)
+            {
+                source.getNextAudioBlock(juce::AudioSourceChannelInfo(&stereo, 0, blockSize));
+            });
+
+            timeBlocks("memory source mono mix " + direction, [&](int)
+            {
+                source.getNextAudioBlock(juce::AudioSourceChannelInfo(&mono, 0, blockSize));
+            });
+        }
+    }
+
+    //==============================================================================
+    // One key-locked stereo deck at several tempos. Its multiple of real time is
+    // roughly how many such decks one core could stretch.
+    void benchmarkTimeStretcher()
+    {
+        SampleStorage storage;
+        makeTrack(storage, SampleStorage::Format::Float32);
+
+        juce::AudioBuffer<float> output(2, blockSize);
+
+        for (const double increment : { 0.8, 1.06, 1.5 })
+        {
+            TimeStretcher stretcher;
+            stretcher.prepare(sampleRate, 2);
+
+            // Grains reach either side of the playhead, so it wraps well inside the track.
+            // It starts between samples, as a deck's usually is, or tempos that move it a
+            // whole number of samples per block would skip resampling their grains.
+            const double reach = stretcher.getReach(1.0);
+            const double first = reach + 0.37, last = (double)storage.getNumSamples() - reach - blockSize * increment;
+            double position = first;
+
+            timeBlocks("time stretcher " + juce::String(increment, 2) + "x", [&](int)
+            {
+                stretcher.process(storage, 1.0, output, 0, blockSize, position, increment, 0.0);
+
+                if ((position += blockSize * increment) >= last)
+                    position = first;
+            });
+        }
+    }
+
+    //==============================================================================
+    // One deck's EQ on a stereo block, held still and with the mid gain gliding to a new
+    // setting every fifty blocks
+    void benchmarkIsolatorEQ()
+    {
+        const auto signal = makeSignal(blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+
+        for (const bool moving : { false, true })
+        {
+            IsolatorEQ eq;
+            eq.prepare(sampleRate);
+
+            timeBlocks(juce::String("isolator eq ") + (moving ? "gliding" : "steady"), [&](int block)
+            {
+                if (moving && block % 50 == 0)
+                    eq.setBandGain(IsolatorEQ::Band::mid, block % 100 == 0 ? 0.5f : 1.0f);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    buffer.copyFrom(channel, 0, signal.data(), blockSize);
+
+                eq.process(buffer, 0, blockSize);
+            });
+        }
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    const juce::String filter = argc > 1 ? juce::String(argv[1]) : juce::String();
+
+    const std::pair<const char*, void (*)()> benchmarks[] = {
+        { "isolator eq", benchmarkIsolatorEQ },
+        { "memory source", benchmarkMemorySource },
+        { "resampler", benchmarkResampler },
+        { "sample storage", benchmarkSampleStorage },
+        { "time stretcher", benchmarkTimeStretcher }
+    };
+
+    for (const auto& [name, run] : benchmarks)
+        if (filter.isEmpty() || juce::String(name).contains(filter))
+            run();
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 // AudioRecorder.h 
 #pragma once
 #include <JuceHeader.h>
+#include "LevelMeter.h"
 
 class AudioRecorder
 {
@@ -14,6 +15,10 @@ public:
         sampleRate = sr;
         numChannels = channels;
 
+        // Starts from silence for each take. The audio thread does the reset, as the
+        // meter's only writer.
+        inputMeter.resetOnNextBlock();
+
         // Ensure parent folder exists
         fileToUse.getParentDirectory().createDirectory();
 
@@ -37,11 +42,16 @@ public:
     }
     bool isRecording() const noexcept { return recording; }
 
+    // What is going into the file, measured as it is written. Prepared with the device.
+    OtoDecksAudio::LevelMeter& getInputMeter() noexcept { return inputMeter; }
+
     // Call from audio thread (fast). Writes current buffer to disk.
     void write(const juce::AudioSourceChannelInfo& bufferToWrite)
     {
         if (!writer) return;
 
+        inputMeter.process(*bufferToWrite.buffer, bufferToWrite.startSample, bufferToWrite.numSamples);
+
         // create a temporary AudioBuffer<float> if needed:
         // writer->writeFromAudioSampleBuffer requires AudioBuffer<float>
         writer->writeFromAudioSampleBuffer(*bufferToWrite.buffer, bufferToWrite.startSample, bufferToWrite.numSamples);
@@ -53,4 +63,5 @@ private:
     double sampleRate;
     int numChannels;
     std::atomic<bool> recording{ false };
+    OtoDecksAudio::LevelMeter inputMeter;
 };
@@ -42,25 +42,7 @@ std::vector<TrackInfo> CSVOperator::readTracksCSV()
         if (line.isEmpty())
             continue;
 
-        // CSV split on commas (basic, no escaping)
-        auto parts = juce::StringArray::fromTokens(line, ",", "");
-
-        TrackInfo info;
-        info.path = parts[0].toStdString();
-
-        if (parts.size() > 1)
-            info.bpm = parts[1].getFloatValue();
-
-        if (parts.size() > 2)
-            info.key = parts[2].toStdString();
-
-        if (parts.size() > 3)
-            info.favorite = (parts[3] == "1");
-
-        if (parts.size() > 4)
-            info.note = parts[4].toStdString();
-
-        tracks.push_back(std::move(info));
+        tracks.push_back(parseTrackLine(line));
     }
     return tracks;
 }
@@ -76,20 +58,84 @@ void CSVOperator::writeTracksCSV(const std::vector<TrackInfo>& tracks)
         return;
     }
     for (const auto& track : tracks)
+        outFile << formatTrackLine(track) << std::endl;
+}
+
+TrackInfo CSVOperator::parseTrackLine(const juce::String& line)
+{
+    // Commas inside quotes don't split a field
+    auto parts = juce::StringArray::fromTokens(line, ",", "\"");
+
+    for (auto& part : parts)
+        if (part.startsWithChar('"') && part.endsWithChar('"') && part.length() > 1)
+            part = part.substring(1, part.length() - 1).replace("\"\"", "\"");
+
+    TrackInfo info;
+    info.path = parts[0].toStdString();
+
+    if (parts.size() > 1)
+        info.bpm = parts[1].getFloatValue();
+
+    if (parts.size() > 2)
+        info.key = parts[2].toStdString();
+
+    if (parts.size() > 3)
+        info.favorite = (parts[3] == "1");
+
+    if (parts.size() > 4)
+        info.note = parts[4].toStdString();
+
+    // Hot cues share one column, separated by semicolons, with '-' for an empty slot
+    if (parts.size() > 5)
+    {
+        auto cues = juce::StringArray::fromTokens(parts[5], ";", "");
+
+        for (int i = 0; i < juce::jmin(cues.size(), TrackInfo::numHotCues); ++i)
+            if (cues[i] != "-" && cues[i].containsOnly("0123456789."))
+                info.hotCues[(size_t)i] = cues[i].getDoubleValue();
+    }
+
+    return info;
+}
+
+std::string CSVOperator::formatTrackLine(const TrackInfo& track)
+{
+    auto escapeCSV = [](const std::string& str) -> std::string
     {
-        // Escape commas in notes or paths if needed (simple version, wrap with quotes if comma found)
-        auto escapeCSV = [](const std::string& str) -> std::string
-        {
-            if (str.find(',') != std::string::npos)
-                return "\"" + str + "\"";
+        if (str.find_first_of(",\"") == std::string::npos)
             return str;
-        };
-        outFile << escapeCSV(track.path) << ",";
-        outFile << track.bpm << ",";
-        outFile << escapeCSV(track.key) << ",";
-        outFile << (track.favorite ? "1" : "0") << ",";
-        outFile << escapeCSV(track.note) << std::endl;
+
+        return "\"" + juce::String(str).replace("\"", "\"\"").toStdString() + "\"";
+    };
+
+    std::string line = escapeCSV(track.path) + ","
+                     + juce::String(track.bpm).toStdString() + ","
+                     + escapeCSV(track.key) + ","
+                     + (track.favorite ? "1" : "0") + ","
+                     + escapeCSV(track.note) + ",";
+
+    for (int i = 0; i < TrackInfo::numHotCues; ++i)
+    {
+        if (i > 0)
+            line += ";";
+
+        if (track.hotCues[(size_t)i] >= 0.0)
+            line += juce::String(track.hotCues[(size_t)i], 4).toStdString();
+        else
+            line += "-";
     }
+
+   #if JUCE_DEBUG
+    // Every row has to read back as it was written, or its hot cues land in the wrong column
+    const auto readBack = parseTrackLine(line);
+    jassert(readBack.path == track.path && readBack.key == track.key && readBack.note == track.note
+            && readBack.favorite == track.favorite);
+
+    for (int i = 0; i < TrackInfo::numHotCues; ++i)
+        jassert(std::abs(readBack.hotCues[(size_t)i] - (track.hotCues[(size_t)i] < 0.0 ? -1.0 : track.hotCues[(size_t)i])) < 1.0e-3);
+   #endif
+
+    return line;
 }
 
 void CSVOperator::addNewTrack(const juce::String& path)
@@ -109,3 +155,16 @@ void CSVOperator::removeTrack(int rowNumber)
         writeTracksCSV(tracks);
     }
 }
+
+bool CSVOperator::updateTrack(const std::string& path, const std::function<void(TrackInfo&)>& change)
+{
+    auto tracks = readTracksCSV();
+    auto track = std::find_if(tracks.begin(), tracks.end(), [&path](const TrackInfo& t) { return t.path == path; });
+
+    if (track == tracks.end())
+        return false;
+
+    change(*track);
+    writeTracksCSV(tracks);
+    return true;
+}
@@ -5,6 +5,8 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
+#include <array>
+#include <functional>
 
 struct TrackInfo
 {
@@ -14,6 +16,10 @@ struct TrackInfo
     bool favorite = false;
     std::string note;
 
+    // Hot cue positions in seconds, or -1 for an empty slot
+    static constexpr int numHotCues = 8;
+    std::array<double, numHotCues> hotCues { -1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0 };
+
     TrackInfo() = default;
     TrackInfo(const std::string& p) : path(p) {}
 };
@@ -35,6 +41,11 @@ public:
     // Removes track at given index
     static void removeTrack(int rowNumber);
 
+    // Re-reads the file and changes only the track with this path, so columns other
+    // owners have written since (hot cues, notes) aren't lost. Returns false, and writes
+    // nothing, if the track isn't in the file.
+    static bool updateTrack(const std::string& path, const std::function<void(TrackInfo&)>& change);
+
 private:
     // Reads CSV line-by-line and parses TrackInfo objects
     static std::vector<TrackInfo> readTracksCSV();
@@ -42,5 +53,10 @@ private:
     // Writes vector of TrackInfo to CSV file
     static void writeTracksCSV(const std::vector<TrackInfo>& tracks);
 
+    // One row of the file each way. Fields with commas or quotes are quoted, with any
+    // quotes inside doubled, so paths like "Artist, feat. X" keep every column in place.
+    static TrackInfo parseTrackLine(const juce::String& line);
+    static std::string formatTrackLine(const TrackInfo& track);
+
     static juce::File getCSVFile();
 };
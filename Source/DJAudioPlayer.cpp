@@ -7,130 +7,180 @@
 */
 
 #include "DJAudioPlayer.h"
+#include "CSVOperator.h"
 #include <juce_core/juce_core.h>
 
-DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager)
+DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager, DecodedTrackCache& _trackCache)
     : formatManager(_formatManager),
-      forwardResampler(&forwardTransport, false),
-      reverseResampler(&reverseTransport, false),
+      trackCache(_trackCache),
       isDraggingPosSlider(false),
       remixReady(false)
 {
+    hotCues.fill(-1.0);
+
+    trackLoader.onTrackLoaded = [this](std::unique_ptr<LoadedTrack> track)
+    {
+        installTrack(std::move(track));
+    };
+
+    startTimer(100);
 }
 
-DJAudioPlayer::~DJAudioPlayer(){}
+DJAudioPlayer::~DJAudioPlayer()
+{
+    stopTimer();
+    saveHotCues();
+
+    // The audio device is shut down by now, so every track can be freed here.
+    // A pending track is always the current one, so it's freed below.
+    pendingTrack = nullptr;
+    delete retiredTrack.exchange(nullptr);
+
+    if (activeTrack != currentTrack)
+        delete activeTrack;
+
+    delete currentTrack;
+}
 
 void DJAudioPlayer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
     currentSampleRate = sampleRate;
+    playhead.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+    appliedGainRampSeconds = gainRampSeconds.load();
+    gainRamp.prepare(sampleRate, appliedGainRampSeconds);
+    gainRamp.setCurrentAndTarget(gain.load());
 
-    forwardTransport.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    reverseTransport.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    eq.prepare(sampleRate);
 
-    forwardResampler.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    reverseResampler.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    // Tracks loaded from now on arrive already at the device rate
+    trackLoader.setDeviceSampleRate(sampleRate);
 }
 
 void DJAudioPlayer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-    if (isReversedFlag)
-        reverseResampler.getNextAudioBlock(bufferToFill);
-    else
-        forwardResampler.getNextAudioBlock(bufferToFill);
+    // Swap in a newly loaded track at the block boundary, but only once the
+    // previous one has been collected so the handover slot is free
+    if (retiredTrack.load(std::memory_order_acquire) == nullptr)
+    {
+        if (auto* nextTrack = pendingTrack.exchange(nullptr, std::memory_order_acq_rel))
+        {
+            retiredTrack.store(activeTrack, std::memory_order_release);
+            activeTrack = nextTrack;
+            playhead.setTrack(activeTrack->samples.get(), activeTrack->memorySource.get(), activeTrack->sampleRate);
+        }
+    }
+
+    // Always handed to the playhead, so control commands are applied even before a track arrives
+    playhead.renderNextBlock(bufferToFill);
+
+    eq.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+    const double rampSeconds = gainRampSeconds.load();
+
+    if (rampSeconds != appliedGainRampSeconds)
+    {
+        appliedGainRampSeconds = rampSeconds;
+        gainRamp.setRampTime(rampSeconds);
+    }
+
+    gainRamp.setTarget(gain.load());
+    gainRamp.applyGain(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
 }
 
 void DJAudioPlayer::releaseResources()
 {
-    forwardTransport.releaseResources();
-    reverseTransport.releaseResources();
-
-    forwardResampler.releaseResources();
-    reverseResampler.releaseResources();
 }
 
 void DJAudioPlayer::loadURL(juce::URL audioURL)
 {
-    // Stop playback first
-    forwardTransport.stop();
-    reverseTransport.stop();
-
-    // Disconnect sources from transport before releasing them
-    forwardTransport.setSource(nullptr);
-    reverseTransport.setSource(nullptr);
+    // Stop playback first, the current track keeps its place until the new one is decoded
+    stop();
+    startWhenLoaded = true;
 
-    // Reset your unique_ptrs to release old sources and free memory
-    forwardSource.reset();
-    reverseMemorySource.reset();
+    // Any cue changes still waiting belong to the outgoing track
+    saveHotCues();
 
-    // Clear buffers (optional but clean)
-    audioBuffer.clear();
-    reversedBuffer.clear();
+    // Take the beat grid and hot cues from the track list if the track is in it
+    setBeatGrid(0.0, 0.0);
+    trackPath.clear();
+    hotCues.fill(-1.0);
 
-    // Now load the new audio
-    juce::URL::InputStreamOptions options((juce::URL::ParameterHandling)0);
-    auto* reader = formatManager.createReaderFor(audioURL.createInputStream(options));
-
-    if (reader != nullptr)
+    if (audioURL.isLocalFile())
     {
-        audioBuffer.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
-        reader->read(&audioBuffer, 0, (int)reader->lengthInSamples, 0, true, true);
-
-        // Setup forward transport source
-        std::unique_ptr<juce::AudioFormatReaderSource> newSource(new juce::AudioFormatReaderSource(reader, true));
-        forwardTransport.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-        forwardSource.reset(newSource.release());
+        trackPath = audioURL.getLocalFile().getFullPathName().toStdString();
 
-        // Prepare reversed buffer and reverseMemorySource as before
-        reversedBuffer.setSize(audioBuffer.getNumChannels(), audioBuffer.getNumSamples());
-        for (int channel = 0; channel < audioBuffer.getNumChannels(); ++channel)
+        for (const auto& info : CSVOperator::loadAllTracks())
         {
-            auto* writePtr = reversedBuffer.getWritePointer(channel);
-            auto* readPtr = audioBuffer.getReadPointer(channel);
-            int numSamples = audioBuffer.getNumSamples();
+            if (info.path != trackPath)
+                continue;
+
+            if (info.bpm > 0.0f)
+                setBeatGrid(info.bpm, 0.0);
 
-            for (int i = 0; i < numSamples; ++i)
-                writePtr[i] = readPtr[numSamples - 1 - i];
+            hotCues = info.hotCues;
         }
+    }
 
-        reverseMemorySource.reset(new OtoDecksAudio::MemoryAudioSource(reversedBuffer, false));
-        reverseTransport.setSource(reverseMemorySource.get(), 0, nullptr, reader->sampleRate);
+    trackLoader.load(audioURL);
+}
 
-        isReversedFlag = false;
-        forwardTransport.start();
-    }
-    else
-    {
-        DBG("Something went wrong loading the file");
-    }
+void DJAudioPlayer::installTrack(std::unique_ptr<LoadedTrack> newTrack)
+{
+    currentTrack = newTrack.release();
+
+    // A new track always starts forwards from the top. The playhead applies this as it
+    // takes the track, so none of it can reach the track being replaced.
+    playhead.expectTrack(startWhenLoaded);
+
+    // The audio thread is done with anything it has handed back, so clearing the slot now
+    // means the swap never has to wait for the timer
+    delete retiredTrack.exchange(nullptr, std::memory_order_acq_rel);
+
+    // If the audio thread never picked up the previous pending track, nobody else can be using it
+    if (auto* unusedTrack = pendingTrack.exchange(currentTrack, std::memory_order_acq_rel))
+        delete unusedTrack;
+
+    loopInPosition = -1.0;
+    pinHotCues();
+}
+
+void DJAudioPlayer::timerCallback()
+{
+    delete retiredTrack.exchange(nullptr, std::memory_order_acq_rel);
+
+    if (hotCuesChanged && juce::Time::getMillisecondCounter() - hotCuesChangedTime >= hotCueSaveDelayMs)
+        saveHotCues();
 }
 
 void DJAudioPlayer::setPositionRelative(double pos)
 {
-    pos = juce::jlimit(0.0, 1.0, pos);
-    double length = getLengthInSeconds();
-    double posSecs = length * pos;
+    if (currentTrack == nullptr)
+        return;
 
-    if (isReversedFlag && reverseMemorySource)
-    {
-        // In reverse mode, slider=0 is end of file, slider=1 is start
-        reverseTransport.setPosition(juce::jmax(0.0, length - posSecs));
-    }
-    else
-    {
-        forwardTransport.setPosition(posSecs);
-    }
+    // Positions are always on the forward timeline, whichever way the track is playing
+    pos = juce::jlimit(0.0, 1.0, pos);
+    playhead.setPosition(pos * currentTrack->samples->getNumSamples());
 }
 
-void DJAudioPlayer::setGain(double gain)
+void DJAudioPlayer::setGain(double newGain)
 {
-    forwardTransport.setGain(gain);
-    reverseTransport.setGain(gain);
+    gain = (float)newGain;
 }
 
 void DJAudioPlayer::setSpeed(double ratio)
 {
-    forwardResampler.setResamplingRatio(ratio);
-    reverseResampler.setResamplingRatio(ratio);
+    playhead.setSpeed(ratio);
+}
+
+void DJAudioPlayer::setGainRampTime(double seconds)
+{
+    gainRampSeconds = juce::jmax(0.0, seconds);
+}
+
+void DJAudioPlayer::setSpeedRampTime(double seconds)
+{
+    playhead.setRateRampTime(seconds);
 }
 
 double DJAudioPlayer::getPositionRelative()
@@ -138,137 +188,363 @@ double DJAudioPlayer::getPositionRelative()
     double length = getLengthInSeconds();
     if (length <= 0.0) return 0.0;
 
-    if (isReversedFlag && reverseMemorySource)
-    {
-        // Reverse transport position in seconds
-        double posSecs = reverseTransport.getCurrentPosition();
-        if (std::isnan(posSecs)) return 0.0;
-
-        // Convert so slider still goes left → right for forward timeline
-        return 1.0 - (posSecs / length);
-    }
-    else
-    {
-        double posSecs = forwardTransport.getCurrentPosition();
-        if (std::isnan(posSecs)) return 0.0;
-
-        return posSecs / length;
-    }
+    return juce::jlimit(0.0, 1.0, getCurrentPosition() / length);
 }
 
 void DJAudioPlayer::start()
 {
-    if (isReversedFlag)
-    {
-        // Convert actual reverse position to forward position before switching
-        double posReverse = reverseTransport.getCurrentPosition();
-        reverseTransport.stop();
-
-        double forwardPos = getLengthInSeconds() - posReverse;
-        forwardTransport.setPosition(forwardPos);
-        forwardTransport.start();
-        isReversedFlag = false;
-    }
-    else
-    {
-        if (!forwardTransport.isPlaying())
-            forwardTransport.start();
-    }
+    startForward();
 }
 
 void DJAudioPlayer::startForward()
 {
-    if (isReversedFlag)
+    // While a track is loading, just remember to play it once it arrives
+    if (trackLoader.isLoading())
     {
-        // Switch from reverse → forward playback
-        double posReverse = reverseTransport.getCurrentPosition();
-        reverseTransport.stop();
-
-        double forwardPos = getLengthInSeconds() - posReverse;
-        forwardTransport.setPosition(forwardPos);
-        forwardTransport.start();
-        isReversedFlag = false;
-    }
-    else
-    {
-        if (!forwardTransport.isPlaying())
-            forwardTransport.start();
+        startWhenLoaded = true;
+        return;
     }
+
+    if (currentTrack == nullptr)
+        return;
+
+    // Flipping the rate's sign turns the playhead around on the exact sample it is on
+    playhead.setReversed(false);
+    playhead.setPlaying(true);
 }
 
 void DJAudioPlayer::startReverse()
 {
-    if (!isReversedFlag)
-    {
-        // Switch from forward → reverse playback
-        double posForward = forwardTransport.getCurrentPosition();
-        forwardTransport.stop();
+    if (trackLoader.isLoading() || currentTrack == nullptr)
+        return;
 
-        reverseTransport.setPosition(getLengthInSeconds() - posForward);
-        reverseTransport.start();
-        isReversedFlag = true;
-    }
-    else
-    {
-        // Already in reverse mode, just start/resume if not playing
-        if (!reverseTransport.isPlaying())
-            reverseTransport.start();
-    }
+    playhead.setReversed(true);
+    playhead.setPlaying(true);
 }
 
 void DJAudioPlayer::stop()
 {
-    if (isReversedFlag)
-        reverseTransport.stop();
-    else
-        forwardTransport.stop();
+    if (trackLoader.isLoading())
+        startWhenLoaded = false;
+
+    playhead.setPlaying(false);
+}
+
+void DJAudioPlayer::brake(double seconds)
+{
+    playhead.brake(seconds);
+}
+
+void DJAudioPlayer::spinback(double seconds)
+{
+    playhead.spinback(seconds);
+}
+
+void DJAudioPlayer::nudge(double rateOffset)
+{
+    playhead.setNudge(rateOffset);
+}
+
+void DJAudioPlayer::scratch(double rate)
+{
+    playhead.setScratchRate(rate);
+}
+
+void DJAudioPlayer::endScratch()
+{
+    playhead.endScratch();
 }
 
 void DJAudioPlayer::setPosition(double posInSecs)
 {
-    if (isReversedFlag && reverseMemorySource)
+    if (currentTrack != nullptr)
+        playhead.setPosition(posInSecs * currentTrack->sampleRate);
+}
+
+void DJAudioPlayer::setBeatGrid(double newBeatsPerMinute, double newFirstBeatSeconds, int newBeatsPerBar)
+{
+    beatsPerMinute = newBeatsPerMinute;
+    firstBeatSeconds = newFirstBeatSeconds;
+    beatsPerBar = juce::jmax(1, newBeatsPerBar);
+}
+
+double DJAudioPlayer::getCurrentTempo() const
+{
+    if (currentTrack == nullptr || beatsPerMinute <= 0.0)
+        return 0.0;
+
+    return beatsPerMinute * std::abs(playhead.getCurrentRate());
+}
+
+juce::int64 DJAudioPlayer::getNextBeatTime(Quantize quantize) const
+{
+    if (currentTrack == nullptr || beatsPerMinute <= 0.0)
+        return -1;
+
+    const auto timing = playhead.getTiming();
+
+    if (timing.rate == 0.0)
+        return -1;
+
+    const double spacing = 60.0 / beatsPerMinute * (quantize == Quantize::Bar ? beatsPerBar : 1);
+    const double seconds = timing.position / currentTrack->sampleRate;
+    const double direction = timing.rate > 0.0 ? 1.0 : -1.0;
+
+    // The next line in whichever direction the track is playing
+    const double beats = (seconds - firstBeatSeconds) / spacing;
+    double line = direction > 0.0 ? std::floor(beats) + 1.0 : std::ceil(beats) - 1.0;
+
+    // The snapshot is a block or so old by the time the command lands, so skip lines
+    // too close to reach in time
+    auto getDelay = [&] { return (firstBeatSeconds + line * spacing - seconds) * currentSampleRate / timing.rate; };
+
+    while (getDelay() < currentSampleRate * minimumLeadSeconds)
+        line += direction;
+
+    return timing.sampleClock + (juce::int64)std::ceil(getDelay());
+}
+
+void DJAudioPlayer::startAt(juce::int64 sampleTime)
+{
+    if (trackLoader.isLoading() || currentTrack == nullptr)
+        return;
+
+    playhead.setPlayingAt(true, sampleTime);
+}
+
+void DJAudioPlayer::stopAt(juce::int64 sampleTime)
+{
+    playhead.setPlayingAt(false, sampleTime);
+}
+
+void DJAudioPlayer::setPositionAt(double posInSecs, juce::int64 sampleTime)
+{
+    if (currentTrack != nullptr)
+        playhead.setPositionAt(posInSecs * currentTrack->sampleRate, sampleTime);
+}
+
+void DJAudioPlayer::setLoopIn()
+{
+    if (currentTrack != nullptr)
+        loopInPosition = snapToBeat(playhead.getPosition());
+}
+
+void DJAudioPlayer::setLoopOut()
+{
+    if (currentTrack == nullptr || loopInPosition < 0.0)
+        return;
+
+    // On a grid the out point snaps to the coming beat rather than the nearest, so the
+    // playhead is still inside the loop when it closes
+    const double position = playhead.getPosition();
+    const double beatLength = getBeatLength();
+    const double loopOutPosition = beatLength > 0.0 ? getLineBefore(position, 1.0) + beatLength : position;
+
+    if (loopOutPosition > loopInPosition)
+        playhead.setLoop(loopInPosition, loopOutPosition);
+}
+
+void DJAudioPlayer::setAutoLoop(double beats)
+{
+    const double beatLength = getBeatLength();
+
+    if (beatLength <= 0.0)
+        return;
+
+    beats = juce::jlimit(minLoopBeats, maxLoopBeats, beats);
+    const double start = getLineBefore(playhead.getPosition(), beats);
+
+    loopInPosition = start;
+    playhead.setLoop(start, start + beats * beatLength);
+}
+
+void DJAudioPlayer::halveLoop()
+{
+    resizeLoop(0.5);
+}
+
+void DJAudioPlayer::doubleLoop()
+{
+    resizeLoop(2.0);
+}
+
+void DJAudioPlayer::resizeLoop(double factor)
+{
+    if (!playhead.isLooping())
+        return;
+
+    // The loop keeps its start; the playhead follows it in if the end moves back past it
+    const double start = playhead.getLoopStart();
+    const double beatLength = getBeatLength();
+    double length = (playhead.getLoopEnd() - start) * factor;
+
+    if (beatLength > 0.0)
+        length = juce::jlimit(minLoopBeats * beatLength, maxLoopBeats * beatLength, length);
+
+    playhead.setLoop(start, start + juce::jmax(1.0, length));
+}
+
+void DJAudioPlayer::exitLoop()
+{
+    playhead.clearLoop();
+}
+
+void DJAudioPlayer::beginLoopRoll(double beats)
+{
+    const double beatLength = getBeatLength();
+
+    if (beatLength <= 0.0)
+        return;
+
+    beats = juce::jlimit(minLoopBeats, maxLoopBeats, beats);
+    const double start = getLineBefore(playhead.getPosition(), beats);
+    playhead.beginLoopRoll(start, start + beats * beatLength);
+}
+
+void DJAudioPlayer::endLoopRoll()
+{
+    playhead.endLoopRoll();
+}
+
+void DJAudioPlayer::setHotCue(int index, bool snapToGrid)
+{
+    if (!juce::isPositiveAndBelow(index, numHotCues) || currentTrack == nullptr || trackLoader.isLoading())
+        return;
+
+    const double position = playhead.getPosition();
+    hotCues[(size_t)index] = (snapToGrid ? snapToBeat(position) : position) / currentTrack->sampleRate;
+
+    pinHotCues();
+    hotCuesEdited();
+}
+
+void DJAudioPlayer::clearHotCue(int index)
+{
+    if (!juce::isPositiveAndBelow(index, numHotCues) || trackLoader.isLoading())
+        return;
+
+    hotCues[(size_t)index] = -1.0;
+
+    pinHotCues();
+    hotCuesEdited();
+}
+
+double DJAudioPlayer::getHotCue(int index) const
+{
+    return juce::isPositiveAndBelow(index, numHotCues) ? hotCues[(size_t)index] : -1.0;
+}
+
+void DJAudioPlayer::jumpToHotCue(int index, bool quantized)
+{
+    const double cue = getHotCue(index);
+
+    if (cue < 0.0 || currentTrack == nullptr || trackLoader.isLoading())
+        return;
+
+    const auto beatTime = quantized ? getNextBeatTime(Quantize::Beat) : -1;
+
+    if (beatTime >= 0)
     {
-        int posInSamples = static_cast<int>(posInSecs * currentSampleRate);
-        int reversePos = reversedBuffer.getNumSamples() - posInSamples - 1;
-        reverseMemorySource->setPosition(reversePos);
-        reverseTransport.setPosition(posInSecs);
+        setPositionAt(cue, beatTime);
+        return;
     }
-    else
+
+    setPosition(cue);
+
+    if (!isPlaying())
+        startForward();
+}
+
+void DJAudioPlayer::pinHotCues()
+{
+    static_assert(numHotCues <= OtoDecksAudio::TrackSamples::maxPinnedRegions, "Every hot cue needs a pin");
+
+    if (currentTrack == nullptr)
+        return;
+
+    for (int i = 0; i < numHotCues; ++i)
     {
-        forwardTransport.setPosition(posInSecs);
+        const double cue = hotCues[(size_t)i];
+        currentTrack->samples->pinRegion(i, cue < 0.0 ? -1 : (juce::int64)(cue * currentTrack->sampleRate));
     }
 }
 
+void DJAudioPlayer::hotCuesEdited()
+{
+    hotCuesChanged = true;
+    hotCuesChangedTime = juce::Time::getMillisecondCounter();
+}
+
+void DJAudioPlayer::saveHotCues()
+{
+    if (!hotCuesChanged)
+        return;
+
+    hotCuesChanged = false;
+
+    // Tracks dropped onto the deck from outside the library keep their cues only while loaded
+    if (!trackPath.empty())
+        CSVOperator::updateTrack(trackPath, [this](TrackInfo& info) { info.hotCues = hotCues; });
+}
+
+double DJAudioPlayer::getBeatLength() const
+{
+    if (currentTrack == nullptr || beatsPerMinute <= 0.0)
+        return 0.0;
+
+    return 60.0 / beatsPerMinute * currentTrack->sampleRate;
+}
+
+double DJAudioPlayer::snapToBeat(double position) const
+{
+    const double beatLength = getBeatLength();
+
+    if (beatLength <= 0.0)
+        return position;
+
+    const double firstBeat = firstBeatSeconds * currentTrack->sampleRate;
+    return juce::jmax(0.0, firstBeat + std::round((position - firstBeat) / beatLength) * beatLength);
+}
+
+double DJAudioPlayer::getLineBefore(double position, double beats) const
+{
+    // Loops of a beat or more start on a beat, shorter ones on a line of their own length
+    const double spacing = getBeatLength() * juce::jmin(1.0, beats);
+    const double firstBeat = firstBeatSeconds * currentTrack->sampleRate;
+    return juce::jmax(0.0, firstBeat + std::floor((position - firstBeat) / spacing) * spacing);
+}
+
 double DJAudioPlayer::sendTimer()
 {
-    if (isReversedFlag && reverseMemorySource)
-        return reverseMemorySource->getCurrentPosition();
-    else
-        return forwardTransport.getCurrentPosition();
+    return getCurrentPosition();
 }
 
 bool DJAudioPlayer::isTrackFinished()
 {
-    if (isReversedFlag)
-        return reverseTransport.hasStreamFinished();
-    else
-        return forwardTransport.hasStreamFinished();
+    // Nothing can finish while the next track is still being decoded
+    if (currentTrack == nullptr || trackLoader.isLoading())
+        return false;
+
+    return playhead.hasFinished();
 }
 
 double DJAudioPlayer::getCurrentPosition() const
 {
-    if (isReversedFlag)
-        return reverseTransport.getCurrentPosition();
-    else
-        return forwardTransport.getCurrentPosition();
+    if (currentTrack == nullptr)
+        return 0.0;
+
+    return playhead.getPosition() / currentTrack->sampleRate;
 }
 
 double DJAudioPlayer::getLengthInSeconds() const
 {
-    return forwardTransport.getLengthInSeconds(); // Both should be equal
+    if (currentTrack == nullptr)
+        return 0.0;
+
+    return currentTrack->samples->getNumSamples() / currentTrack->sampleRate;
 }
 
 bool DJAudioPlayer::isPlaying() const
 {
-    return isReversedFlag ? reverseTransport.isPlaying() : forwardTransport.isPlaying();
+    return currentTrack != nullptr && playhead.isPlaying();
 }
@@ -9,20 +9,51 @@
 #pragma once
 #include <JuceHeader.h>
 #include "MemoryAudioSource.h"
-
-class DJAudioPlayer : public juce::AudioSource {
+#include "DeckPlayhead.h"
+#include "TrackLoader.h"
+#include "ParameterRamp.h"
+#include "IsolatorEQ.h"
+#include "CSVOperator.h"
+
+class DJAudioPlayer : public juce::AudioSource,
+                      private juce::Timer
+{
     public:
 
-        DJAudioPlayer(juce::AudioFormatManager& _formatManager);
+        DJAudioPlayer(juce::AudioFormatManager& _formatManager, DecodedTrackCache& _trackCache);
         ~DJAudioPlayer();
 
         void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
         void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
         void releaseResources() override;
 
+        // Starts decoding the track in the background; it replaces the current one once ready
         void loadURL(juce::URL audioURL);
-        void setGain(double gain);
+        void setGain(double newGain);
         void setSpeed(double ratio);
+
+        // How long gain and speed changes take to glide to their new value, so faders,
+        // mute and 2X never step. Zero makes them land within a single block.
+        void setGainRampTime(double seconds);
+        void setSpeedRampTime(double seconds);
+
+        // Three band isolator EQ, ahead of the deck gain. Gains run from 0 to
+        // IsolatorEQ::maxBandGain, and a kill silences its band whatever the gain.
+        using EQBand = OtoDecksAudio::IsolatorEQ::Band;
+
+        void setEQGain(EQBand band, float newGain) { eq.setBandGain(band, newGain); }
+        void setEQKill(EQBand band, bool shouldKill) { eq.setBandKill(band, shouldKill); }
+        float getEQGain(EQBand band) const { return eq.getBandGain(band); }
+        bool isEQKilled(EQBand band) const { return eq.isBandKilled(band); }
+
+        // Resampling quality used whenever the deck isn't playing at exactly normal speed
+        void setResamplerQuality(OtoDecksAudio::Resampler::Quality quality) { playhead.setQuality(quality); }
+        OtoDecksAudio::Resampler::Quality getResamplerQuality() const { return playhead.getQuality(); }
+
+        // Keeps the pitch where it is while the speed slider changes the tempo
+        void setKeyLock(bool shouldLockKey) { playhead.setKeyLock(shouldLockKey); }
+        bool isKeyLocked() const { return playhead.isKeyLocked(); }
+        double getKeyLockLatency() const { return playhead.getKeyLockLatency(); }
        
         void setPosition(double posInSecs);
         void setPositionRelative(double pos);
@@ -44,25 +75,147 @@ class DJAudioPlayer : public juce::AudioSource {
         double getLengthInSeconds() const;
         bool isPlaying() const;
 
-        bool isReversed() const { return isReversedFlag; } 
+        bool isReversed() const { return playhead.isReversed(); } 
         double getSampleRate() const { return currentSampleRate; }
 
+        // Turntable moves, all driven by the playhead's signed rate
+        void brake(double seconds);
+        void spinback(double seconds);
+        void nudge(double rateOffset);
+        void scratch(double rate);
+        void endScratch();
+
+        // Background loading state
+        TrackLoader::State getLoadState() const { return trackLoader.getState(); }
+        bool isLoading() const { return trackLoader.isLoading(); }
+        float getLoadProgress() const { return trackLoader.getProgress(); }
+
+        // Memory format for decoded tracks; the compact formats take half the memory of float
+        void setSampleFormat(OtoDecksAudio::SampleStorage::Format format) { trackLoader.setStorageFormat(format); }
+
+        // Tracks bigger than the budget stream from disk instead of being decoded into memory
+        void setStreamingPolicy(juce::int64 memoryBudgetBytes, double lookAheadSeconds) { trackLoader.setStreamingPolicy(memoryBudgetBytes, lookAheadSeconds); }
+
+        // True while a streamed track is catching up with a seek
+        bool isBuffering() const { return playhead.isBuffering(); }
+
+        // Sample-accurate scheduling. Times are on the deck's sample clock, which counts
+        // output samples and runs in step with every other deck's.
+        enum class Quantize { Beat, Bar };
+
+        // Where the beats fall in the current track. Loading a track picks up its BPM
+        // from the track list, with the first beat at the very start.
+        void setBeatGrid(double beatsPerMinute, double firstBeatSeconds, int beatsPerBar = 4);
+
+        // When the playhead will cross the next beat or bar line at its current speed,
+        // or -1 if it isn't moving or the track has no beat grid
+        juce::int64 getNextBeatTime(Quantize quantize) const;
+
+        // The tempo the deck is playing at right now, or 0 if it isn't moving or has no beat grid
+        double getCurrentTempo() const;
+
+        juce::int64 getSampleClock() const { return playhead.getTiming().sampleClock; }
+
+        void startAt(juce::int64 sampleTime);
+        void stopAt(juce::int64 sampleTime);
+        void setPositionAt(double posInSecs, juce::int64 sampleTime);
+
+        // Loops. With a beat grid, loop in snaps to the nearest beat, loop out to the coming
+        // one, and auto loops and rolls start on the last line of their own length, so the
+        // playhead is always inside them. Auto loops and rolls need a beat grid; without one they do nothing.
+        void setLoopIn();
+        void setLoopOut();
+        void setAutoLoop(double beats);
+        void halveLoop();
+        void doubleLoop();
+        void exitLoop();
+
+        // Loops for as long as it's held, then carries on as if it never had
+        void beginLoopRoll(double beats);
+        void endLoopRoll();
+
+        bool isLooping() const { return playhead.isLooping(); }
+
+        // Hot cues, in seconds, kept with the track if it's in the library. Jumping to one plays
+        // from it at the start of the next block, or on the next beat if quantized and the
+        // deck is playing. Streamed tracks keep the audio after each cue on hand.
+        static constexpr int numHotCues = TrackInfo::numHotCues;
+
+        void setHotCue(int index, bool snapToGrid = false);
+        void clearHotCue(int index);
+        double getHotCue(int index) const;
+        void jumpToHotCue(int index, bool quantized = false);
+
+        // Loop lengths for auto loops, rolls, and halving and doubling on a beat grid
+        static constexpr double minLoopBeats = 0.25;
+        static constexpr double maxLoopBeats = 32.0;
+
     private:
+        // Hands a decoded track over to the audio thread
+        void installTrack(std::unique_ptr<LoadedTrack> newTrack);
+
+        // Track positions in source samples for beat-based loops
+        double getBeatLength() const;
+        double snapToBeat(double position) const;
+        double getLineBefore(double position, double beats) const;
+        void resizeLoop(double factor);
+
+        // Keeps the audio after every hot cue ready, and the library up to date. Edits are
+        // written once the pads have been left alone for a moment, not on every press.
+        void pinHotCues();
+        void hotCuesEdited();
+        void saveHotCues();
+
+        // Frees tracks the audio thread has finished with, and saves settled hot cues
+        void timerCallback() override;
+
+        static constexpr juce::uint32 hotCueSaveDelayMs = 1000;
+
+        // How far ahead a quantized action has to be scheduled to reach the audio thread in time
+        static constexpr double minimumLeadSeconds = 0.05;
+
+        static constexpr double defaultGainRampSeconds = 0.02;
+
         juce::AudioFormatManager& formatManager;
-        juce::AudioBuffer<float> audioBuffer;
-        juce::AudioBuffer<float> reversedBuffer;
-        std::unique_ptr<juce::AudioFormatReaderSource> forwardSource;
-        std::unique_ptr<OtoDecksAudio::MemoryAudioSource> reverseMemorySource;
-        juce::AudioTransportSource forwardTransport;
-        juce::AudioTransportSource reverseTransport;
+        DecodedTrackCache& trackCache;
+
+        // The newest installed track, used by the message thread for transport control
+        LoadedTrack* currentTrack = nullptr;
 
-        // For speed control
-        juce::ResamplingAudioSource forwardResampler { &forwardTransport, false };
-        juce::ResamplingAudioSource reverseResampler { &reverseTransport, false };
+        // Track handover between threads: the message thread publishes into pendingTrack,
+        // the audio thread swaps it in at the start of a block and hands the old one back
+        // through retiredTrack so it is never freed on the audio thread
+        std::atomic<LoadedTrack*> pendingTrack { nullptr };
+        std::atomic<LoadedTrack*> retiredTrack { nullptr };
+        LoadedTrack* activeTrack = nullptr;
+
+        OtoDecksAudio::DeckPlayhead playhead;
+        OtoDecksAudio::IsolatorEQ eq;
 
         double currentSampleRate = 44100.0;
-        bool isReversedFlag = false;
+        std::atomic<float> gain { 1.0f };
+        std::atomic<double> gainRampSeconds { defaultGainRampSeconds };
+
+        // Owned by the audio thread
+        OtoDecksAudio::ParameterRamp gainRamp;
+        double appliedGainRampSeconds = defaultGainRampSeconds;
+        bool startWhenLoaded = true;
+
+        double beatsPerMinute = 0.0;
+        double firstBeatSeconds = 0.0;
+        int beatsPerBar = 4;
+
+        // The loop in point waiting for its out point, or -1
+        double loopInPosition = -1.0;
+
+        // The library entry the hot cues belong to
+        std::string trackPath;
+        std::array<double, numHotCues> hotCues {};
+        bool hotCuesChanged = false;
+        juce::uint32 hotCuesChangedTime = 0;
 
         bool isDraggingPosSlider = false;
         bool remixReady = false;
+
+        TrackLoader trackLoader { formatManager, trackCache };
 };
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    DeckCommandQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // One request from the controls to a deck's audio thread
+    struct DeckCommand
+    {
+        enum class Type
+        {
+            Play,
+            Stop,
+            SetReversed,    // value is 1 for backwards, 0 for forwards
+            Seek,           // value is the new position in source samples
+            Brake,          // value is the time to stop in, in seconds
+            Spinback,       // value is the time to stop in, in seconds
+            BeginScratch,
+            EndScratch,
+            SetQuality,     // value is a Resampler::Quality
+            SetKeyLock,     // value is 1 for on, 0 for off
+            SetLoop,        // value and loopEnd are the loop's edges in source samples
+            ClearLoop,
+            BeginLoopRoll,  // value and loopEnd are the loop's edges in source samples
+            EndLoopRoll
+        };
+
+        Type type = Type::Stop;
+        double value = 0.0;
+
+        // The deck's sample clock time to apply it at, or -1 for the start of the next block
+        juce::int64 time = -1;
+
+        // Increases by one with every command, so the controls can tell once it has been applied
+        juce::uint32 id = 0;
+
+        double loopEnd = 0.0;
+    };
+
+    // Carries deck commands from the message thread to the audio thread in the order
+    // they were sent. Both ends are wait-free, so the audio thread drains it at the
+    // start of every block without risk of being held up by the GUI.
+    //
+    // Only one thread may push and only one may drain.
+    class DeckCommandQueue
+    {
+    public:
+        DeckCommandQueue() = default;
+
+        // Returns false if the queue is full, which only happens if the audio thread has
+        // stopped draining it
+        bool push(const DeckCommand& command) noexcept
+        {
+            const auto scope = fifo.write(1);
+
+            if (scope.blockSize1 == 0)
+                return false;
+
+            commands[(size_t)scope.startIndex1] = command;
+            return true;
+        }
+
+        // Calls the function for every waiting command, oldest first
+        template <typename Function>
+        void drain(Function&& function) noexcept
+        {
+            const auto scope = fifo.read(fifo.getNumReady());
+            scope.forEach([this, &function] (int index) { function(commands[(size_t)index]); });
+        }
+
+    private:
+        static constexpr int capacity = 256;
+
+        juce::AbstractFifo fifo { capacity };
+        std::array<DeckCommand, capacity> commands;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckCommandQueue)
+    };
+}
@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+    DeckEffects.cpp
+
+  ==============================================================================
+*/
+
+#include "DeckEffects.h"
+
+namespace OtoDecksAudio
+{
+    void DeckEffect::prepare(double newSampleRate, int newMaximumBlockSize)
+    {
+        sampleRate = newSampleRate;
+        maximumBlockSize = newMaximumBlockSize;
+        glideCoefficient = (float)(1.0 - std::exp(-1.0 / (glideSeconds * sampleRate)));
+        smoothedMix = mix.load();
+
+        prepareEffect();
+        reset();
+    }
+
+    //==============================================================================
+    void FilterSweepEffect::prepareEffect()
+    {
+        smoothedPosition = position.load();
+    }
+
+    void FilterSweepEffect::reset() noexcept
+    {
+        std::fill(std::begin(s1), std::end(s1), 0.0f);
+        std::fill(std::begin(s2), std::end(s2), 0.0f);
+    }
+
+    void FilterSweepEffect::updateCoefficients(float sweep) noexcept
+    {
+        // Past the dead zone the cutoff moves exponentially, so the knob sweeps evenly by ear
+        const double amount = (std::abs(sweep) - deadZone) / (1.0 - deadZone);
+        const double frequency = juce::jmin(sampleRate * 0.45, highPass ? 20.0 * std::pow(400.0, amount)
+                                                                         : 20000.0 * std::pow(0.005, amount));
+
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosW = std::cos(w);
+        const double alpha = std::sin(w) / (2.0 * 0.9);
+        const double a0 = 1.0 + alpha;
+        const double sign = highPass ? -1.0 : 1.0;
+
+        b0 = (float)((1.0 - sign * cosW) * 0.5 / a0);
+        b1 = (float)(sign * (1.0 - sign * cosW) / a0);
+        b2 = b0;
+        a1 = (float)(-2.0 * cosW / a0);
+        a2 = (float)((1.0 - alpha) / a0);
+    }
+
+    void FilterSweepEffect::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context&) noexcept
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+        const float targetPosition = position.load(std::memory_order_relaxed);
+        const float targetMix = mix.load(std::memory_order_relaxed);
+
+        for (int offset = 0; offset < numSamples; offset += updateInterval)
+        {
+            const int num = juce::jmin(updateInterval, numSamples - offset);
+
+            for (int i = 0; i < num; ++i)
+                smoothedPosition = glide(smoothedPosition, targetPosition);
+
+            // Each side of the dead zone starts from a clean filter
+            if (std::abs(smoothedPosition) < deadZone)
+            {
+                reset();
+                smoothedMix = targetMix;
+                continue;
+            }
+
+            if ((smoothedPosition > 0.0f) != highPass)
+            {
+                highPass = smoothedPosition > 0.0f;
+                reset();
+            }
+
+            updateCoefficients(smoothedPosition);
+
+            float channelMix = smoothedMix;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                float* samples = buffer.getWritePointer(channel, startSample + offset);
+                channelMix = smoothedMix;
+
+                for (int i = 0; i < num; ++i)
+                {
+                    const float x = samples[i];
+                    const float y = b0 * x + s1[channel];
+                    s1[channel] = b1 * x - a1 * y + s2[channel];
+                    s2[channel] = b2 * x - a2 * y;
+
+                    channelMix = glide(channelMix, targetMix);
+                    samples[i] = x + channelMix * (y - x);
+                }
+            }
+
+            smoothedMix = channelMix;
+        }
+    }
+
+    //==============================================================================
+    void EchoEffect::prepareEffect()
+    {
+        delayLine.setSize(maxChannels, (int)(maxDelaySeconds * sampleRate) + 2);
+        smoothedFeedback = feedback.load();
+    }
+
+    void EchoEffect::reset() noexcept
+    {
+        delayLine.clear();
+        writeIndex = 0;
+        smoothedDelay = 0.0f;
+    }
+
+    double EchoEffect::getTailSeconds() const noexcept
+    {
+        // Until the repeats have died away by 60 dB
+        const double gain = juce::jmax(0.01, (double)feedback.load());
+        return juce::jmin(30.0, delaySeconds.load() * std::log(0.001) / std::log(gain));
+    }
+
+    void EchoEffect::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+        const int lineLength = delayLine.getNumSamples();
+
+        const float targetDelay = (float)juce::jlimit(1.0, (double)lineLength - 2.0,
+                                                      beats.load(std::memory_order_relaxed) * context.beatSeconds * sampleRate);
+        const float targetFeedback = feedback.load(std::memory_order_relaxed);
+        const float targetMix = mix.load(std::memory_order_relaxed);
+
+        delaySeconds.store((float)(targetDelay / sampleRate), std::memory_order_relaxed);
+
+        if (smoothedDelay == 0.0f)
+            smoothedDelay = targetDelay;
+
+        // Slower than the other parameters, so a new length sweeps like a tape echo
+        const float delayGlide = glideCoefficient * 0.1f;
+
+        float* lines[maxChannels] = { delayLine.getWritePointer(0), delayLine.getWritePointer(1) };
+        float* samples[maxChannels] = {};
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            samples[channel] = buffer.getWritePointer(channel, startSample);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            smoothedDelay += (targetDelay - smoothedDelay) * delayGlide;
+            smoothedFeedback = glide(smoothedFeedback, targetFeedback);
+            smoothedMix = glide(smoothedMix, targetMix);
+
+            float readPosition = (float)writeIndex - smoothedDelay;
+
+            if (readPosition < 0.0f)
+                readPosition += (float)lineLength;
+
+            const int index0 = (int)readPosition;
+            const int index1 = index0 + 1 < lineLength ? index0 + 1 : 0;
+            const float fraction = readPosition - (float)index0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const float delayed = lines[channel][index0] + fraction * (lines[channel][index1] - lines[channel][index0]);
+                const float x = samples[channel][i];
+
+                lines[channel][writeIndex] = x + smoothedFeedback * delayed;
+                samples[channel][i] = x + smoothedMix * delayed;
+            }
+
+            if (++writeIndex == lineLength)
+                writeIndex = 0;
+        }
+    }
+
+    //==============================================================================
+    void ReverbEffect::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context&) noexcept
+    {
+        // The reverb smooths level changes itself. It doubles the dry level, so a half
+        // leaves the dry signal as it is.
+        auto parameters = appliedParameters;
+        parameters.roomSize = size.load(std::memory_order_relaxed);
+        parameters.damping = 0.5f;
+        parameters.width = 1.0f;
+        parameters.dryLevel = 0.5f;
+        parameters.wetLevel = 0.5f * mix.load(std::memory_order_relaxed);
+
+        if (parameters.roomSize != appliedParameters.roomSize || parameters.wetLevel != appliedParameters.wetLevel
+             || parameters.dryLevel != appliedParameters.dryLevel)
+        {
+            reverb.setParameters(parameters);
+            appliedParameters = parameters;
+        }
+
+        if (buffer.getNumChannels() >= 2)
+            reverb.processStereo(buffer.getWritePointer(0, startSample), buffer.getWritePointer(1, startSample), numSamples);
+        else if (buffer.getNumChannels() == 1)
+            reverb.processMono(buffer.getWritePointer(0, startSample), numSamples);
+    }
+
+    //==============================================================================
+    void FlangerEffect::prepareEffect()
+    {
+        delayLine.setSize(maxChannels, (int)((minDelaySeconds + sweepSeconds) * sampleRate) + 4);
+        smoothedDepth = depth.load();
+        smoothedFeedback = feedback.load();
+    }
+
+    void FlangerEffect::reset() noexcept
+    {
+        delayLine.clear();
+        writeIndex = 0;
+    }
+
+    void FlangerEffect::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context&) noexcept
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+        const int lineLength = delayLine.getNumSamples();
+
+        const double phaseStep = juce::MathConstants<double>::twoPi * rate.load(std::memory_order_relaxed) / sampleRate;
+        const float targetDepth = depth.load(std::memory_order_relaxed);
+        const float targetFeedback = feedback.load(std::memory_order_relaxed);
+        const float targetMix = mix.load(std::memory_order_relaxed);
+
+        float* lines[maxChannels] = { delayLine.getWritePointer(0), delayLine.getWritePointer(1) };
+        float* samples[maxChannels] = {};
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            samples[channel] = buffer.getWritePointer(channel, startSample);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            smoothedDepth = glide(smoothedDepth, targetDepth);
+            smoothedFeedback = glide(smoothedFeedback, targetFeedback);
+            smoothedMix = glide(smoothedMix, targetMix);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const double sweep = 0.5 - 0.5 * std::cos(phase + channel * juce::MathConstants<double>::halfPi);
+                float readPosition = (float)writeIndex - (float)((minDelaySeconds + smoothedDepth * sweepSeconds * sweep) * sampleRate);
+
+                if (readPosition < 0.0f)
+                    readPosition += (float)lineLength;
+
+                const int index0 = (int)readPosition;
+                const int index1 = index0 + 1 < lineLength ? index0 + 1 : 0;
+                const float fraction = readPosition - (float)index0;
+
+                const float delayed = lines[channel][index0] + fraction * (lines[channel][index1] - lines[channel][index0]);
+                const float x = samples[channel][i];
+
+                lines[channel][writeIndex] = x + smoothedFeedback * delayed;
+
+                // A full mix is an even blend, which is where the notches are deepest
+                samples[channel][i] = x + 0.5f * smoothedMix * (delayed - x);
+            }
+
+            if (++writeIndex == lineLength)
+                writeIndex = 0;
+
+            phase += phaseStep;
+
+            if (phase >= juce::MathConstants<double>::twoPi)
+                phase -= juce::MathConstants<double>::twoPi;
+        }
+    }
+
+    //==============================================================================
+    void BitcrushEffect::reset() noexcept
+    {
+        std::fill(std::begin(held), std::end(held), 0.0f);
+        holdPhase = downsample.load();
+    }
+
+    void BitcrushEffect::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context&) noexcept
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+        const float factor = downsample.load(std::memory_order_relaxed);
+        const float step = 2.0f / std::pow(2.0f, bits.load(std::memory_order_relaxed));
+        const float targetMix = mix.load(std::memory_order_relaxed);
+
+        float* samples[maxChannels] = {};
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            samples[channel] = buffer.getWritePointer(channel, startSample);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            smoothedMix = glide(smoothedMix, targetMix);
+
+            // Take a new sample every factor samples, fractions included, and hold it in between
+            holdPhase += 1.0f;
+            const bool takeSample = holdPhase >= factor;
+
+            if (takeSample)
+                holdPhase -= factor;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const float x = samples[channel][i];
+
+                if (takeSample)
+                    held[channel] = std::round(x / step) * step;
+
+                samples[channel][i] = x + smoothedMix * (held[channel] - x);
+            }
+        }
+    }
+}
@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    DeckEffects.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // An effect in a deck's effects rack. Parameters are atomics, so any thread can set
+    // them; they are picked up at the next block and glide from there. Everything an
+    // effect needs is allocated in prepare, never while processing.
+    class DeckEffect
+    {
+    public:
+        virtual ~DeckEffect() = default;
+
+        // What the rack knows about the block being processed
+        struct Context
+        {
+            // Length of a beat at the deck's current tempo
+            double beatSeconds = 0.5;
+        };
+
+        // Not on the audio thread while this effect is in use. Blocks are never longer
+        // than maximumBlockSize.
+        void prepare(double newSampleRate, int newMaximumBlockSize);
+
+        virtual void reset() noexcept = 0;
+
+        // Processes the first two channels in place. Output is the dry signal plus the
+        // effect, so silence in gives just the effect's tail out.
+        virtual void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept = 0;
+
+        // How long the effect keeps sounding once its input goes silent
+        virtual double getTailSeconds() const noexcept { return 0.0; }
+
+        // How far the output runs behind the input
+        virtual int getLatencySamples() const noexcept { return 0; }
+
+        // Dry/wet balance, from 0 to 1
+        void setMix(float newMix) noexcept { mix = juce::jlimit(0.0f, 1.0f, newMix); }
+        float getMix() const noexcept { return mix.load(); }
+
+    protected:
+        explicit DeckEffect(float initialMix) noexcept : mix(initialMix), smoothedMix(initialMix) {}
+
+        virtual void prepareEffect() = 0;
+
+        // Moves a smoothed parameter a sample's worth towards its target
+        float glide(float current, float target) const noexcept { return current + (target - current) * glideCoefficient; }
+
+        static constexpr int maxChannels = 2;
+
+        double sampleRate = 44100.0;
+        int maximumBlockSize = 512;
+        float glideCoefficient = 1.0f;
+
+        std::atomic<float> mix;
+        float smoothedMix;
+
+    private:
+        // Time constant of every parameter glide
+        static constexpr double glideSeconds = 0.02;
+    };
+
+    //==============================================================================
+    // One knob DJ filter: left of centre a low pass closes down from the top, right of
+    // centre a high pass opens up from the bottom, and the middle is a straight bypass
+    class FilterSweepEffect : public DeckEffect
+    {
+    public:
+        FilterSweepEffect() noexcept : DeckEffect(1.0f) {}
+
+        // -1 to 1
+        void setPosition(float newPosition) noexcept { position = juce::jlimit(-1.0f, 1.0f, newPosition); }
+        float getPosition() const noexcept { return position.load(); }
+
+        void reset() noexcept override;
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept override;
+
+    private:
+        void prepareEffect() override;
+        void updateCoefficients(float sweep) noexcept;
+
+        // Coefficients follow the knob this many samples at a time
+        static constexpr int updateInterval = 32;
+        static constexpr float deadZone = 0.02f;
+
+        std::atomic<float> position { 0.0f };
+        float smoothedPosition = 0.0f;
+        bool highPass = false;
+
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float s1[maxChannels] {}, s2[maxChannels] {};
+    };
+
+    //==============================================================================
+    // Delay locked to the beat. Changing the length glides the delay like tape, rather
+    // than jumping it.
+    class EchoEffect : public DeckEffect
+    {
+    public:
+        EchoEffect() noexcept : DeckEffect(0.5f) {}
+
+        void setBeats(float newBeats) noexcept { beats = juce::jlimit(minBeats, maxBeats, newBeats); }
+        void setFeedback(float newFeedback) noexcept { feedback = juce::jlimit(0.0f, maxFeedback, newFeedback); }
+        float getBeats() const noexcept { return beats.load(); }
+        float getFeedback() const noexcept { return feedback.load(); }
+
+        void reset() noexcept override;
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept override;
+        double getTailSeconds() const noexcept override;
+
+        static constexpr float minBeats = 0.125f;
+        static constexpr float maxBeats = 4.0f;
+        static constexpr float maxFeedback = 0.95f;
+
+    private:
+        void prepareEffect() override;
+
+        static constexpr double maxDelaySeconds = 4.0;
+
+        std::atomic<float> beats { 0.75f };
+        std::atomic<float> feedback { 0.5f };
+
+        // Written by the audio thread for getTailSeconds
+        std::atomic<float> delaySeconds { 0.375f };
+
+        juce::AudioBuffer<float> delayLine;
+        int writeIndex = 0;
+        float smoothedDelay = 0.0f;
+        float smoothedFeedback = 0.5f;
+    };
+
+    //==============================================================================
+    // JUCE's Freeverb-style reverb
+    class ReverbEffect : public DeckEffect
+    {
+    public:
+        ReverbEffect() noexcept : DeckEffect(0.3f) {}
+
+        void setSize(float newSize) noexcept { size = juce::jlimit(0.0f, 1.0f, newSize); }
+        float getSize() const noexcept { return size.load(); }
+
+        void reset() noexcept override { reverb.reset(); }
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept override;
+        double getTailSeconds() const noexcept override { return 1.0 + 5.0 * size.load(); }
+
+    private:
+        void prepareEffect() override { reverb.setSampleRate(sampleRate); }
+
+        std::atomic<float> size { 0.6f };
+        juce::Reverb reverb;
+        juce::Reverb::Parameters appliedParameters;
+    };
+
+    //==============================================================================
+    // Short delay swept by a slow sine, the two channels a quarter cycle apart
+    class FlangerEffect : public DeckEffect
+    {
+    public:
+        FlangerEffect() noexcept : DeckEffect(0.5f) {}
+
+        void setRate(float newRateHz) noexcept { rate = juce::jlimit(0.05f, 5.0f, newRateHz); }
+        void setDepth(float newDepth) noexcept { depth = juce::jlimit(0.0f, 1.0f, newDepth); }
+        void setFeedback(float newFeedback) noexcept { feedback = juce::jlimit(-0.9f, 0.9f, newFeedback); }
+
+        void reset() noexcept override;
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept override;
+        double getTailSeconds() const noexcept override { return 0.1; }
+
+    private:
+        void prepareEffect() override;
+
+        static constexpr double minDelaySeconds = 0.001;
+        static constexpr double sweepSeconds = 0.005;
+
+        std::atomic<float> rate { 0.25f };
+        std::atomic<float> depth { 0.7f };
+        std::atomic<float> feedback { 0.5f };
+
+        juce::AudioBuffer<float> delayLine;
+        int writeIndex = 0;
+        double phase = 0.0;
+        float smoothedDepth = 0.7f;
+        float smoothedFeedback = 0.5f;
+    };
+
+    //==============================================================================
+    // Fewer bits and a lower sample rate, held rather than filtered for the grit
+    class BitcrushEffect : public DeckEffect
+    {
+    public:
+        BitcrushEffect() noexcept : DeckEffect(1.0f) {}
+
+        void setBits(float newBits) noexcept { bits = juce::jlimit(1.0f, 16.0f, newBits); }
+        void setDownsample(float newFactor) noexcept { downsample = juce::jlimit(1.0f, 32.0f, newFactor); }
+
+        void reset() noexcept override;
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept override;
+
+    private:
+        void prepareEffect() override { reset(); }
+
+        std::atomic<float> bits { 8.0f };
+        std::atomic<float> downsample { 4.0f };
+
+        float held[maxChannels] {};
+        float holdPhase = 1.0f;
+    };
+}
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    DeckEffectsRack.cpp
+
+  ==============================================================================
+*/
+
+#include "DeckEffectsRack.h"
+
+namespace OtoDecksAudio
+{
+    DeckEffectsRack::DeckEffectsRack(juce::AudioSource& inputSource)
+        : input(inputSource)
+    {
+        startTimer(100);
+    }
+
+    DeckEffectsRack::~DeckEffectsRack()
+    {
+        stopTimer();
+
+        // The audio device is shut down by now, so every chain can be freed here
+        delete pendingChain.exchange(nullptr);
+        delete retiredChain.exchange(nullptr);
+        delete activeChain;
+    }
+
+    //==============================================================================
+    void DeckEffectsRack::insertEffect(std::shared_ptr<DeckEffect> effect)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (currentSampleRate > 0.0)
+            effect->prepare(currentSampleRate, currentBlockSize);
+
+        effects.push_back(std::move(effect));
+        publish();
+    }
+
+    void DeckEffectsRack::removeEffect(DeckEffect* effect)
+    {
+        const juce::ScopedLock sl(lock);
+
+        auto found = std::find_if(effects.begin(), effects.end(),
+                                  [effect](const std::shared_ptr<DeckEffect>& e) { return e.get() == effect; });
+
+        if (found == effects.end())
+            return;
+
+        releaseEffect(*found);
+        effects.erase(found);
+        publish();
+    }
+
+    void DeckEffectsRack::moveEffect(DeckEffect* effect, int newIndex)
+    {
+        const juce::ScopedLock sl(lock);
+
+        auto found = std::find_if(effects.begin(), effects.end(),
+                                  [effect](const std::shared_ptr<DeckEffect>& e) { return e.get() == effect; });
+
+        if (found == effects.end())
+            return;
+
+        auto moved = *found;
+        effects.erase(found);
+        effects.insert(effects.begin() + juce::jlimit(0, (int)effects.size(), newIndex), std::move(moved));
+        publish();
+    }
+
+    void DeckEffectsRack::clearEffects()
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (auto& effect : effects)
+            releaseEffect(effect);
+
+        effects.clear();
+        publish();
+    }
+
+    int DeckEffectsRack::getNumEffects() const
+    {
+        const juce::ScopedLock sl(lock);
+        return (int)effects.size();
+    }
+
+    DeckEffect* DeckEffectsRack::getEffect(int index) const
+    {
+        const juce::ScopedLock sl(lock);
+        return juce::isPositiveAndBelow(index, (int)effects.size()) ? effects[(size_t)index].get() : nullptr;
+    }
+
+    void DeckEffectsRack::setTempo(double beatsPerMinute) noexcept
+    {
+        if (beatsPerMinute > 0.0)
+            beatSeconds = 60.0 / beatsPerMinute;
+    }
+
+    int DeckEffectsRack::getLatencySamples() const
+    {
+        const juce::ScopedLock sl(lock);
+        int latency = 0;
+
+        for (const auto& effect : effects)
+            latency += effect->getLatencySamples();
+
+        return latency;
+    }
+
+    void DeckEffectsRack::releaseEffect(std::shared_ptr<DeckEffect> effect)
+    {
+        // Also catches infinite tails, which would overflow the end time
+        const double tailSeconds = juce::jmin(effect->getTailSeconds(), maxTailSeconds);
+
+        if (tailSeconds > 0.0)
+            released.push_back({ std::move(effect), juce::Time::getMillisecondCounter() + (juce::uint32)(tailSeconds * 1000.0) });
+    }
+
+    void DeckEffectsRack::publish()
+    {
+        auto* chain = new Chain { effects, {} };
+
+        // Tails still ringing from earlier changes carry on in the new chain, for however
+        // long they have left
+        const auto now = juce::Time::getMillisecondCounter();
+
+        released.erase(std::remove_if(released.begin(), released.end(),
+                                      [now](const ReleasedEffect& r) { return r.hasRungOut(now); }),
+                       released.end());
+
+        if (currentSampleRate > 0.0)
+            for (const auto& r : released)
+                chain->tails.push_back({ r.effect, (juce::int64)((r.endTime - now) * 0.001 * currentSampleRate) });
+
+        // A chain the audio thread never picked up was never used, so it can go straight away
+        delete pendingChain.exchange(chain, std::memory_order_acq_rel);
+    }
+
+    void DeckEffectsRack::timerCallback()
+    {
+        delete retiredChain.exchange(nullptr, std::memory_order_acq_rel);
+
+        // The playing chain holds on to its tails until another replaces it, so once any have
+        // rung out a chain without them is swapped in, and they're freed when it retires
+        const juce::ScopedLock sl(lock);
+        const auto now = juce::Time::getMillisecondCounter();
+
+        if (std::any_of(released.begin(), released.end(), [now](const ReleasedEffect& r) { return r.hasRungOut(now); }))
+            publish();
+    }
+
+    //==============================================================================
+    void DeckEffectsRack::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+    {
+        const juce::ScopedLock sl(lock);
+
+        input.prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+        currentSampleRate = sampleRate;
+        currentBlockSize = juce::jmax(samplesPerBlockExpected, 512);
+        tailBuffer.setSize(2, currentBlockSize);
+
+        for (auto& effect : effects)
+            effect->prepare(sampleRate, currentBlockSize);
+
+        // Tails are cut off by a device restart anyway
+        released.clear();
+        publish();
+    }
+
+    void DeckEffectsRack::releaseResources()
+    {
+        input.releaseResources();
+    }
+
+    void DeckEffectsRack::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+    {
+        // Swap in the newest chain at the block boundary, once the last one has been collected
+        if (retiredChain.load(std::memory_order_acquire) == nullptr)
+        {
+            if (auto* nextChain = pendingChain.exchange(nullptr, std::memory_order_acq_rel))
+            {
+                retiredChain.store(activeChain, std::memory_order_release);
+                activeChain = nextChain;
+            }
+        }
+
+        input.getNextAudioBlock(bufferToFill);
+
+        if (activeChain == nullptr)
+            return;
+
+        DeckEffect::Context context;
+        context.beatSeconds = beatSeconds.load(std::memory_order_relaxed);
+
+        for (const auto& effect : activeChain->effects)
+            effect->process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples, context);
+
+        if (!activeChain->tails.empty())
+            renderTails(bufferToFill, context);
+    }
+
+    void DeckEffectsRack::renderTails(const juce::AudioSourceChannelInfo& bufferToFill, const DeckEffect::Context& context)
+    {
+        const int numChannels = juce::jmin(bufferToFill.buffer->getNumChannels(), tailBuffer.getNumChannels());
+
+        for (auto& tail : activeChain->tails)
+        {
+            const int numToRender = (int)juce::jmin((juce::int64)bufferToFill.numSamples, tail.samplesRemaining);
+
+            for (int offset = 0; offset < numToRender;)
+            {
+                const int num = juce::jmin(tailBuffer.getNumSamples(), numToRender - offset);
+
+                tailBuffer.clear(0, num);
+                tail.effect->process(tailBuffer, 0, num, context);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    bufferToFill.buffer->addFrom(channel, bufferToFill.startSample + offset, tailBuffer, channel, 0, num);
+
+                offset += num;
+            }
+
+            tail.samplesRemaining -= numToRender;
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    DeckEffectsRack.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DeckEffects.h"
+
+namespace OtoDecksAudio
+{
+    // A chain of effects on the way out of a deck. The rack plays its input, then runs
+    // it through each effect in turn.
+    //
+    // Changing the chain never locks or allocates on the audio thread. Every change
+    // builds a whole new chain on the message thread, with its effects already
+    // prepared, and publishes it. The audio thread swaps it in at the start of a block
+    // and hands the old one back to be freed here.
+    //
+    // Effects that stay in the chain carry on with their state. Effects taken out keep
+    // ringing: the new chain carries them on the side, fed silence and added to the
+    // output, until their tails have died away.
+    class DeckEffectsRack : public juce::AudioSource,
+                            private juce::Timer
+    {
+    public:
+        explicit DeckEffectsRack(juce::AudioSource& inputSource);
+        ~DeckEffectsRack() override;
+
+        // Message thread. Adds an effect to the end of the chain and returns it, so its
+        // parameters can be set. The rack owns it.
+        template <typename EffectType>
+        EffectType* addEffect()
+        {
+            auto effect = std::make_shared<EffectType>();
+            auto* raw = effect.get();
+            insertEffect(std::move(effect));
+            return raw;
+        }
+
+        // Message thread. Adds an effect made elsewhere, such as a hosted plugin.
+        void addEffect(std::unique_ptr<DeckEffect> effect) { insertEffect(std::move(effect)); }
+
+        // Message thread
+        void removeEffect(DeckEffect* effect);
+        void moveEffect(DeckEffect* effect, int newIndex);
+        void clearEffects();
+
+        int getNumEffects() const;
+        DeckEffect* getEffect(int index) const;
+
+        // The deck's tempo, for beat-synced effects. Ignored unless positive, so the last
+        // tempo holds while the deck is stopped.
+        void setTempo(double beatsPerMinute) noexcept;
+
+        // Message thread. How far the chain as it stands delays the deck, for the mixer to
+        // line the decks up by.
+        int getLatencySamples() const;
+
+        // Longest a removed effect is left ringing. Plugins may report an endless tail.
+        static constexpr double maxTailSeconds = 30.0;
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+        void releaseResources() override;
+
+    private:
+        struct Tail
+        {
+            std::shared_ptr<DeckEffect> effect;
+            juce::int64 samplesRemaining = 0;   // counted down by the audio thread
+        };
+
+        struct Chain
+        {
+            std::vector<std::shared_ptr<DeckEffect>> effects;
+            std::vector<Tail> tails;
+        };
+
+        // An effect taken out of the chain, and when its tail should have finished
+        struct ReleasedEffect
+        {
+            std::shared_ptr<DeckEffect> effect;
+            juce::uint32 endTime = 0;
+
+            bool hasRungOut(juce::uint32 now) const noexcept { return (juce::int32)(endTime - now) <= 0; }
+        };
+
+        void insertEffect(std::shared_ptr<DeckEffect> effect);
+        void releaseEffect(std::shared_ptr<DeckEffect> effect);
+        void publish();
+        void timerCallback() override;
+
+        void renderTails(const juce::AudioSourceChannelInfo& bufferToFill, const DeckEffect::Context& context);
+
+        juce::AudioSource& input;
+
+        // Owned by the message thread, and locked against the device thread's prepareToPlay
+        juce::CriticalSection lock;
+        std::vector<std::shared_ptr<DeckEffect>> effects;
+        std::vector<ReleasedEffect> released;
+        double currentSampleRate = 0.0;
+        int currentBlockSize = 512;
+
+        // Chain handover, as for tracks and mixer voices
+        std::atomic<Chain*> pendingChain { nullptr };
+        std::atomic<Chain*> retiredChain { nullptr };
+        Chain* activeChain = nullptr;
+
+        std::atomic<double> beatSeconds { 0.5 };
+
+        // Where tails render before they are added in, sized in prepareToPlay
+        juce::AudioBuffer<float> tailBuffer;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckEffectsRack)
+    };
+}
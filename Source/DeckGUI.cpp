@@ -26,6 +26,8 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& _formatManage
     addAndMakeVisible(posSlider);
     addAndMakeVisible(muteButton);
     addAndMakeVisible(twiceSpeedButton);
+    addAndMakeVisible(keyLockButton);
+    addAndMakeVisible(quantizeButton);
     addAndMakeVisible(trackListComponent);
     addAndMakeVisible(waveformDisplay);
     addAndMakeVisible(remixButton);
@@ -54,6 +56,16 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& _formatManage
         genreSelector.setVisible(false);
     };
 
+    addAndMakeVisible(qualitySelector);
+    qualitySelector.addItem("Linear Resampling", 1);
+    qualitySelector.addItem("Cubic Resampling", 2);
+    qualitySelector.addItem("Sinc Resampling", 3);
+    qualitySelector.setSelectedId((int)player->getResamplerQuality() + 1, juce::dontSendNotification);
+    qualitySelector.onChange = [this]()
+    {
+        player->setResamplerQuality((OtoDecksAudio::Resampler::Quality)(qualitySelector.getSelectedId() - 1));
+    };
+
     // Listeners
     playButton.addListener(this);
     stopButton.addListener(this);
@@ -66,6 +78,8 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& _formatManage
     loadPlaylistButton.addListener(this);
     muteButton.addListener(this);
     twiceSpeedButton.addListener(this);
+    keyLockButton.addListener(this);
+    quantizeButton.addListener(this);
 
     // Slider Ranges
     posSlider.setRange(0.0, 1.0, 0.0);
@@ -78,11 +92,77 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& _formatManage
     volSlider.setValue(1);
     speedSlider.setValue(1);
 
-    // Make mute and 2x buttons toggleable and set their 'on' colours
+    // Make mute, quantize, 2x and key lock buttons toggleable and set their 'on' colours
     muteButton.setClickingTogglesState(true);
     muteButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
     twiceSpeedButton.setClickingTogglesState(true);
     twiceSpeedButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
+    keyLockButton.setClickingTogglesState(true);
+    keyLockButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
+    quantizeButton.setClickingTogglesState(true);
+    quantizeButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
+
+    // EQ knobs run from silent to the top boost, double-clicking back to flat
+    const char* bandNames[] = { "LOW", "MID", "HIGH" };
+
+    for (int band = 0; band < OtoDecksAudio::IsolatorEQ::numBands; ++band)
+    {
+        auto& slider = eqSliders[(size_t)band];
+        auto& killButton = eqKillButtons[(size_t)band];
+        const auto eqBand = (DJAudioPlayer::EQBand)band;
+
+        addAndMakeVisible(slider);
+        slider.setSliderStyle(juce::Slider::SliderStyle::Rotary);
+        slider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+        slider.setRange(0.0, OtoDecksAudio::IsolatorEQ::maxBandGain, 0.01);
+        slider.setValue(player->getEQGain(eqBand), juce::dontSendNotification);
+        slider.setDoubleClickReturnValue(true, 1.0);
+        slider.onValueChange = [this, &slider, eqBand]() { player->setEQGain(eqBand, (float)slider.getValue()); };
+
+        addAndMakeVisible(killButton);
+        killButton.setButtonText(juce::String(bandNames[band]) + " KILL");
+        killButton.setClickingTogglesState(true);
+        killButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
+        killButton.setToggleState(player->isEQKilled(eqBand), juce::dontSendNotification);
+        killButton.onClick = [this, &killButton, eqBand]() { player->setEQKill(eqBand, killButton.getToggleState()); };
+    }
+
+    for (auto* button : { &loopInButton, &loopOutButton, &autoLoopButton, &halveLoopButton,
+                          &doubleLoopButton, &exitLoopButton, &rollButton })
+        addAndMakeVisible(button);
+
+    loopInButton.onClick = [this]() { player->setLoopIn(); };
+    loopOutButton.onClick = [this]() { player->setLoopOut(); };
+    autoLoopButton.onClick = [this]() { player->setAutoLoop(4.0); };
+    halveLoopButton.onClick = [this]() { player->halveLoop(); };
+    doubleLoopButton.onClick = [this]() { player->doubleLoop(); };
+    exitLoopButton.onClick = [this]() { player->exitLoop(); };
+
+    // Lit while the deck is looping, whichever button started it
+    autoLoopButton.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
+
+    rollButton.onStateChange = [this]()
+    {
+        if (rollButton.isDown() == isRolling)
+            return;
+
+        isRolling = rollButton.isDown();
+
+        if (isRolling)
+            player->beginLoopRoll(0.25);
+        else
+            player->endLoopRoll();
+    };
+
+    for (int i = 0; i < DJAudioPlayer::numHotCues; ++i)
+    {
+        auto& button = hotCueButtons[(size_t)i];
+
+        addAndMakeVisible(button);
+        button.setButtonText(juce::String(i + 1));
+        button.setColour(juce::TextButton::buttonOnColourId, juce::Colour(0xffd5d5da));
+        button.onClick = [this, i]() { hotCueClicked(i); };
+    }
 
     posSlider.onDragStart = [this]() { isDraggingPosSlider = true; };
     posSlider.onDragEnd = [this]() {
@@ -117,14 +197,19 @@ void DeckGUI::resized()
     double rowH = getHeight() / 20;
     double columnW = getWidth() / 16;
 
+    // Resampling quality above the transport buttons
+    qualitySelector.setBounds(columnW * 4, 0, columnW * 8, rowH * 0.9);
+
     // Button Bounds
     playButton.setBounds(columnW * 4, rowH, columnW * 2.66, rowH * 2);
     stopButton.setBounds(columnW * 6.7, rowH, columnW * 2.66, rowH * 2);
     reverseButton.setBounds(columnW * 9.4, rowH, columnW * 2.66, rowH * 2);
 
     playSelectedButton.setBounds(columnW * 4, rowH * 3, columnW * 8, rowH * 2);
-    muteButton.setBounds(0, rowH * 4, columnW * 4, rowH);
-    twiceSpeedButton.setBounds(columnW * 12, rowH * 4, columnW * 4, rowH);
+    muteButton.setBounds(0, rowH * 4, columnW * 2, rowH);
+    quantizeButton.setBounds(columnW * 2, rowH * 4, columnW * 2, rowH);
+    twiceSpeedButton.setBounds(columnW * 12, rowH * 4, columnW * 2, rowH);
+    keyLockButton.setBounds(columnW * 14, rowH * 4, columnW * 2, rowH);
     
     double buttonY = rowH * 19;
     double buttonH = rowH * 1.2;
@@ -148,7 +233,30 @@ void DeckGUI::resized()
     posSlider.setBounds(columnW * 0.1, rowH * 15, columnW * 15.9, rowH);
     posSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, columnW * 4, rowH * 0.75);
 
-    trackListComponent.setBounds(0, rowH * 5, getWidth(), rowH * 10);
+    trackListComponent.setBounds(0, rowH * 5, getWidth(), rowH * 6);
+
+    // EQ bands side by side below the track list, each a knob with its kill switch beside it
+    const double bandW = getWidth() / (double)eqSliders.size();
+
+    for (size_t band = 0; band < eqSliders.size(); ++band)
+    {
+        eqSliders[band].setBounds(bandW * band, rowH * 11, columnW * 2, rowH * 2);
+        eqKillButtons[band].setBounds(bandW * band + columnW * 2, rowH * 11.5, bandW - columnW * 2.2, rowH);
+    }
+
+    // Loop controls in a row of equal buttons
+    juce::TextButton* loopButtons[] = { &loopInButton, &loopOutButton, &autoLoopButton, &halveLoopButton,
+                                        &doubleLoopButton, &exitLoopButton, &rollButton };
+    const double loopButtonW = getWidth() / (double)std::size(loopButtons);
+
+    for (size_t i = 0; i < std::size(loopButtons); ++i)
+        loopButtons[i]->setBounds(loopButtonW * i, rowH * 13, loopButtonW, rowH);
+
+    // Hot cues in the row above the position slider
+    const double hotCueW = getWidth() / (double)hotCueButtons.size();
+
+    for (size_t i = 0; i < hotCueButtons.size(); ++i)
+        hotCueButtons[i].setBounds(hotCueW * i, rowH * 14, hotCueW, rowH);
     waveformDisplay.setBounds(columnW * 0.1, rowH * 16, columnW * 15.8, rowH * 3);
 }
 
@@ -158,7 +266,15 @@ void DeckGUI::buttonClicked(juce::Button* button)
     {
         if (player != nullptr)
         {
-            player->start();
+            // Drops in on the other deck's next bar when quantize is 'on' and it is playing
+            const auto barTime = quantizeButton.getToggleState() && quantizeReference != nullptr
+                                   ? quantizeReference->getNextBeatTime(DJAudioPlayer::Quantize::Bar)
+                                   : -1;
+
+            if (barTime >= 0)
+                player->startAt(barTime);
+            else
+                player->start();
         }
     }
 
@@ -264,6 +380,11 @@ void DeckGUI::buttonClicked(juce::Button* button)
             player->setSpeed(speedSlider.getValue());
         }
     }
+    // Holds the pitch while the speed changes when 'on'
+    if (button == &keyLockButton)
+    {
+        player->setKeyLock(keyLockButton.getToggleState());
+    }
     if (button == &remixButton)
     {
         if (!remixReady)
@@ -284,6 +405,19 @@ void DeckGUI::buttonClicked(juce::Button* button)
     }
 }
 
+void DeckGUI::hotCueClicked(int index)
+{
+    // With quantize on, cues are set on the beat and jumps wait for the next one
+    const bool quantized = quantizeButton.getToggleState();
+
+    if (juce::ModifierKeys::currentModifiers.isShiftDown())
+        player->clearHotCue(index);
+    else if (player->getHotCue(index) >= 0.0)
+        player->jumpToHotCue(index, quantized);
+    else
+        player->setHotCue(index, quantized);
+}
+
 // Slider Functions
 void DeckGUI::sliderValueChanged(juce::Slider* slider)
 {
@@ -307,11 +441,21 @@ void DeckGUI::timerCallback()
 {
     // Get position from player only once
     double pos = player->getPositionRelative();
+    autoLoopButton.setToggleState(player->isLooping(), juce::dontSendNotification);
+
+    for (int i = 0; i < DJAudioPlayer::numHotCues; ++i)
+        hotCueButtons[(size_t)i].setToggleState(player->getHotCue(i) >= 0.0, juce::dontSendNotification);
+
     // Update slider only if the user isn't dragging it
     if (!isDraggingPosSlider)
         posSlider.setValue(pos, juce::dontSendNotification);
     // Update waveform with the same value
     waveformDisplay.setPositionRelative(pos);
-    // Update your track timer
-    trackListComponent.updateTimer(player->sendTimer());
+    // Update your track timer, or show how far along the background load is
+    if (player->isLoading())
+        trackListComponent.showLoadProgress(player->getLoadProgress());
+    else if (player->isBuffering())
+        trackListComponent.showBuffering();
+    else
+        trackListComponent.updateTimer(player->sendTimer());
 }
@@ -38,10 +38,16 @@ public:
     void filesDropped(const juce::StringArray& files, int x, int y) override;
     void timerCallback() override;
 
+    // With quantize on, play waits for the next bar of the given deck
+    void setQuantizeReference(DJAudioPlayer* referencePlayer) { quantizeReference = referencePlayer; }
+
     WaveformDisplay waveformDisplay;
 
 private:
 
+    // Sets an empty hot cue where the deck is and jumps to a set one; shift-click clears it
+    void hotCueClicked(int index);
+
     juce::TextButton playButton{ "PLAY" };
     juce::TextButton stopButton{ "STOP" };
     juce::TextButton reverseButton{ "REVERSE" };
@@ -49,15 +55,39 @@ private:
     juce::TextButton playSelectedButton{ "PLAY PREPARED TRACK" };
     juce::TextButton muteButton{ "MUTE" };
     juce::TextButton twiceSpeedButton{ "2X" };
+    juce::TextButton keyLockButton{ "KEY LOCK" };
+    juce::TextButton quantizeButton{ "QUANTIZE" };
     juce::TextButton loadPlaylistButton{ "LOAD PLAYLIST" };
     juce::ComboBox genreSelector;
     juce::TextButton remixButton{ "CHOOSE GENRE" };
+
+    // How the deck resamples when it isn't playing at 1x; item ids are the quality's position in the enum, plus one
+    juce::ComboBox qualitySelector;
     juce::File selectedRemixFile;
     bool remixReady = false;
     juce::Slider volSlider;
     juce::Slider speedSlider;
     juce::Slider posSlider;
+
+    // Isolator EQ, one knob and kill switch per band from low to high
+    std::array<juce::Slider, OtoDecksAudio::IsolatorEQ::numBands> eqSliders;
+    std::array<juce::TextButton, OtoDecksAudio::IsolatorEQ::numBands> eqKillButtons;
+
+    // Loops on the beat grid; the roll loops only while it's held down
+    juce::TextButton loopInButton{ "LOOP IN" };
+    juce::TextButton loopOutButton{ "LOOP OUT" };
+    juce::TextButton autoLoopButton{ "LOOP 4" };
+    juce::TextButton halveLoopButton{ "1/2" };
+    juce::TextButton doubleLoopButton{ "X2" };
+    juce::TextButton exitLoopButton{ "EXIT" };
+    juce::TextButton rollButton{ "ROLL 1/4" };
+    bool isRolling = false;
+
+    // Hot cues, lit once they're set
+    std::array<juce::TextButton, DJAudioPlayer::numHotCues> hotCueButtons;
+
     DJAudioPlayer* player;
+    DJAudioPlayer* quantizeReference = nullptr;
     PlaylistComponent* playlist;
     TrackListComponent trackListComponent{ player, &waveformDisplay };
     ModernLookAndFeel modernLNF;
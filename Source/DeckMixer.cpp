@@ -0,0 +1,496 @@
+/*
+  ==============================================================================
+
+    DeckMixer.cpp
+
+  ==============================================================================
+*/
+
+#include "DeckMixer.h"
+
+namespace OtoDecksAudio
+{
+    // Sleeps until the audio thread has a block for it, then helps render it
+    class DeckMixer::Worker : public juce::Thread
+    {
+    public:
+        explicit Worker(DeckMixer& mixerToHelp)
+            : juce::Thread("Deck render worker"), mixer(mixerToHelp) {}
+
+        // Audio thread; never takes a lock
+        void wake() noexcept { semaphore.signal(); }
+
+        void start()
+        {
+            if (!isThreadRunning())
+                startRealtimeThread(juce::Thread::RealtimeOptions{});
+        }
+
+        void stop()
+        {
+            signalThreadShouldExit();
+            wake();
+            stopThread(1000);
+        }
+
+    private:
+        void run() override
+        {
+            // The audio thread has denormals turned off, so the decks rendered here should too
+            juce::ScopedNoDenormals noDenormals;
+
+            while (!threadShouldExit())
+            {
+                semaphore.wait();
+
+                if (!threadShouldExit())
+                    mixer.renderClaimedVoices();
+            }
+        }
+
+        DeckMixer& mixer;
+        RealtimeSemaphore semaphore;
+    };
+
+    //==============================================================================
+    DeckMixer::DeckMixer()
+    {
+        // The audio thread renders its share too, so one fewer than the cores is enough.
+        // Their threads only start once parallel rendering is turned on.
+        const int numWorkers = juce::jlimit(0, 7, juce::SystemStats::getNumCpus() - 1);
+
+        for (int i = 0; i < numWorkers; ++i)
+            workers.push_back(std::make_unique<Worker>(*this));
+
+        startTimer(100);
+    }
+
+    DeckMixer::~DeckMixer()
+    {
+        stopTimer();
+
+        for (auto& worker : workers)
+            worker->stop();
+
+        // The audio device is shut down by now, so every list can be freed here
+        delete pendingList.exchange(nullptr);
+        delete retiredList.exchange(nullptr);
+        delete activeList;
+    }
+
+    //==============================================================================
+    void DeckMixer::setParallelRendering(bool shouldRenderInParallel)
+    {
+        // Threads are running before the audio thread can wake them, and it has stopped
+        // waking them before they stop. A worker that's stopped while it's rendering
+        // finishes the voice first, and voices nobody has claimed go to the audio thread.
+        if (shouldRenderInParallel)
+        {
+            for (auto& worker : workers)
+                worker->start();
+
+            parallelRendering = true;
+        }
+        else
+        {
+            parallelRendering = false;
+
+            for (auto& worker : workers)
+                worker->stop();
+        }
+    }
+
+    void DeckMixer::addVoice(juce::AudioSource* source)
+    {
+        if (source == nullptr)
+            return;
+
+        const juce::ScopedLock sl(lock);
+
+        auto voice = std::make_shared<Voice>();
+        voice->source = source;
+        voice->bus.setSize(numBusChannels, juce::jmax(busLength, 512));
+
+        if (currentSampleRate > 0.0)
+            prepareVoice(*voice);
+
+        voices.push_back(std::move(voice));
+        publish();
+    }
+
+    void DeckMixer::removeVoice(juce::AudioSource* source)
+    {
+        const juce::ScopedLock sl(lock);
+
+        voices.erase(std::remove_if(voices.begin(), voices.end(),
+                                    [source](const std::shared_ptr<Voice>& voice) { return voice->source == source; }),
+                     voices.end());
+        publish();
+    }
+
+    int DeckMixer::getNumVoices() const
+    {
+        const juce::ScopedLock sl(lock);
+        return (int)voices.size();
+    }
+
+    void DeckMixer::setVoiceLatency(juce::AudioSource* source, int samples)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* voice = findVoice(source))
+            voice->latency = juce::jmax(0, samples);
+    }
+
+    void DeckMixer::setVoiceMeter(juce::AudioSource* source, LevelMeter* meter)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* voice = findVoice(source))
+        {
+            // Ready before the audio thread can see it
+            if (meter != nullptr && currentSampleRate > 0.0)
+                meter->prepare(currentSampleRate);
+
+            voice->meter = meter;
+        }
+    }
+
+    void DeckMixer::setChannelFader(juce::AudioSource* source, float gain)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* voice = findVoice(source))
+            voice->fader = juce::jlimit(0.0f, 1.0f, gain);
+    }
+
+    void DeckMixer::setChannelTrim(juce::AudioSource* source, float decibels)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* voice = findVoice(source))
+            voice->trim = juce::Decibels::decibelsToGain(juce::jlimit(minTrimDecibels, maxTrimDecibels, decibels));
+    }
+
+    void DeckMixer::setCrossfaderSide(juce::AudioSource* source, CrossfaderSide side)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* voice = findVoice(source))
+            voice->side = side;
+    }
+
+    void DeckMixer::setCue(juce::AudioSource* source, bool shouldCue)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* voice = findVoice(source))
+            voice->cue = shouldCue;
+    }
+
+    bool DeckMixer::isCued(juce::AudioSource* source) const
+    {
+        const juce::ScopedLock sl(lock);
+
+        auto* voice = findVoice(source);
+        return voice != nullptr && voice->cue.load();
+    }
+
+    float DeckMixer::getCrossfaderGain(CrossfaderCurve curve, CrossfaderSide side, float position) noexcept
+    {
+        if (side == CrossfaderSide::thru)
+            return 1.0f;
+
+        // How far the fader has moved towards this side, from 0 at the far end to 1 at this one
+        const float towards = side == CrossfaderSide::left ? 1.0f - position : position;
+
+        switch (curve)
+        {
+            case CrossfaderCurve::linear:           return towards;
+            case CrossfaderCurve::constantPower:    return std::sin(towards * juce::MathConstants<float>::halfPi);
+            case CrossfaderCurve::sharpCut:         return juce::jmin(1.0f, towards / sharpCutWidth);
+        }
+
+        return 1.0f;
+    }
+
+    DeckMixer::Voice* DeckMixer::findVoice(juce::AudioSource* source) const
+    {
+        for (auto& voice : voices)
+            if (voice->source == source)
+                return voice.get();
+
+        return nullptr;
+    }
+
+    void DeckMixer::publish()
+    {
+        // A list the audio thread never picked up was never used, so it can go straight away
+        delete pendingList.exchange(new VoiceList { voices }, std::memory_order_acq_rel);
+    }
+
+    void DeckMixer::timerCallback()
+    {
+        delete retiredList.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    //==============================================================================
+    void DeckMixer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+    {
+        const juce::ScopedLock sl(lock);
+
+        currentSampleRate = sampleRate;
+
+        // Larger blocks than expected are mixed in pieces, so the audio thread never resizes a bus
+        busLength = juce::jmax(samplesPerBlockExpected, 512);
+
+        masterInCue.prepare(sampleRate, channelRampSeconds);
+
+        for (auto& voice : voices)
+        {
+            voice->bus.setSize(numBusChannels, busLength);
+            prepareVoice(*voice);
+        }
+    }
+
+    void DeckMixer::prepareVoice(Voice& voice)
+    {
+        voice.gain.prepare(currentSampleRate, channelRampSeconds);
+        voice.cueGain.prepare(currentSampleRate, channelRampSeconds);
+
+        voice.compensationLine.setSize(numBusChannels, (int)(maxCompensationSeconds * currentSampleRate) + voice.bus.getNumSamples());
+        voice.compensationLine.clear();
+        voice.compensationWrite = 0;
+        voice.compensationDelay = 0;
+
+        if (auto* meter = voice.meter.load())
+            meter->prepare(currentSampleRate);
+
+        voice.source->prepareToPlay(voice.bus.getNumSamples(), currentSampleRate);
+    }
+
+    void DeckMixer::releaseResources()
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (auto& voice : voices)
+            voice->source->releaseResources();
+    }
+
+    void DeckMixer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+    {
+        // Swap in the newest list at the block boundary, once the last one has been collected
+        if (retiredList.load(std::memory_order_acquire) == nullptr)
+        {
+            if (auto* nextList = pendingList.exchange(nullptr, std::memory_order_acq_rel))
+            {
+                retiredList.store(activeList, std::memory_order_release);
+                activeList = nextList;
+            }
+        }
+
+        bufferToFill.clearActiveBufferRegion();
+
+        if (activeList == nullptr || activeList->voices.empty())
+            return;
+
+        auto& buffer = *bufferToFill.buffer;
+        const int numChannels = juce::jmin(buffer.getNumChannels(), numBusChannels);
+        const int numCueChannels = juce::jlimit(0, numBusChannels, buffer.getNumChannels() - firstCueChannel);
+        const int busSize = activeList->voices.front()->bus.getNumSamples();
+
+        // Channel strips only move at block boundaries, gliding from there
+        const auto curve = crossfaderCurve.load(std::memory_order_relaxed);
+        const float position = crossfader.load(std::memory_order_relaxed);
+        const float mix = cueMix.load(std::memory_order_relaxed);
+        const float level = headphoneLevel.load(std::memory_order_relaxed);
+
+        masterInCue.setTarget(level * mix);
+
+        // Every voice is held back to line up with the one running latest
+        int maxLatency = 0;
+
+        for (const auto& voice : activeList->voices)
+            maxLatency = juce::jmax(maxLatency, voice->latency.load(std::memory_order_relaxed));
+
+        for (const auto& voice : activeList->voices)
+        {
+            voice->gain.setTarget(voice->fader.load(std::memory_order_relaxed)
+                                   * voice->trim.load(std::memory_order_relaxed)
+                                   * getCrossfaderGain(curve, voice->side.load(std::memory_order_relaxed), position));
+
+            voice->cueGain.setTarget(voice->cue.load(std::memory_order_relaxed)
+                                         ? voice->trim.load(std::memory_order_relaxed) * level * (1.0f - mix)
+                                         : 0.0f);
+        }
+
+        for (int offset = 0; offset < bufferToFill.numSamples;)
+        {
+            const int numSamples = juce::jmin(busSize, bufferToFill.numSamples - offset);
+
+            renderVoices(numSamples);
+
+            for (const auto& voice : activeList->voices)
+                delayVoice(*voice, maxLatency - voice->latency.load(std::memory_order_relaxed), numSamples);
+
+            for (const auto& voice : activeList->voices)
+                if (auto* meter = voice->meter.load(std::memory_order_acquire))
+                    meter->process(voice->bus, 0, numSamples, voice->trim.load(std::memory_order_relaxed));
+
+            const int start = bufferToFill.startSample + offset;
+
+            for (const auto& voice : activeList->voices)
+                voice->gain.addWithGain(buffer, start, voice->bus, 0, numChannels, numSamples);
+
+            if (numCueChannels > 0)
+            {
+                const float* master[numBusChannels] = {};
+                const float* bus[numBusChannels] = {};
+                float* cue[numBusChannels] = {};
+
+                for (int channel = 0; channel < numCueChannels; ++channel)
+                {
+                    master[channel] = buffer.getReadPointer(juce::jmin(channel, numChannels - 1), start);
+                    cue[channel] = buffer.getWritePointer(firstCueChannel + channel, start);
+                }
+
+                // Voices that aren't cued have settled at zero and are skipped
+                for (const auto& voice : activeList->voices)
+                {
+                    for (int channel = 0; channel < numCueChannels; ++channel)
+                        bus[channel] = voice->bus.getReadPointer(channel);
+
+                    voice->cueGain.addWithGain(cue, bus, numCueChannels, numSamples);
+                }
+
+                masterInCue.addWithGain(cue, master, numCueChannels, numSamples);
+            }
+
+            offset += numSamples;
+        }
+    }
+
+    void DeckMixer::delayVoice(Voice& voice, int delay, int numSamples) noexcept
+    {
+        auto& line = voice.compensationLine;
+        const int length = line.getNumSamples();
+
+        // The bus goes in first, so the line has to hold the delay and the block both
+        delay = juce::jlimit(0, length - numSamples, delay);
+
+        // Always written, so whatever delay is asked for next already has the deck's own
+        // audio behind it
+        const int writeStart = voice.compensationWrite;
+
+        for (int channel = 0; channel < numBusChannels; ++channel)
+        {
+            const float* bus = voice.bus.getReadPointer(channel);
+            float* ring = line.getWritePointer(channel);
+
+            const int firstWrite = juce::jmin(numSamples, length - writeStart);
+            juce::FloatVectorOperations::copy(ring + writeStart, bus, firstWrite);
+            juce::FloatVectorOperations::copy(ring, bus + firstWrite, numSamples - firstWrite);
+        }
+
+        const int previousDelay = voice.compensationDelay;
+
+        if (delay == previousDelay)
+        {
+            if (delay > 0)
+                for (int channel = 0; channel < numBusChannels; ++channel)
+                    readDelayed(voice, channel, delay, numSamples, 1.0f, 1.0f, false);
+        }
+        else
+        {
+            // A new delay fades in across the chunk over the old one, rather than jumping
+            for (int channel = 0; channel < numBusChannels; ++channel)
+            {
+                readDelayed(voice, channel, previousDelay, numSamples, 1.0f, 0.0f, false);
+                readDelayed(voice, channel, delay, numSamples, 0.0f, 1.0f, true);
+            }
+
+            voice.compensationDelay = delay;
+        }
+
+        voice.compensationWrite = (writeStart + numSamples) % length;
+    }
+
+    void DeckMixer::readDelayed(Voice& voice, int channel, int delay, int numSamples,
+                                float startGain, float endGain, bool addToBus) noexcept
+    {
+        const auto& line = voice.compensationLine;
+        const int length = line.getNumSamples();
+
+        // With no delay this reads back what was just written
+        const int readStart = (voice.compensationWrite - delay + length) % length;
+        const int firstRead = juce::jmin(numSamples, length - readStart);
+        const float splitGain = startGain + (endGain - startGain) * (float)firstRead / (float)numSamples;
+
+        const float* ring = line.getReadPointer(channel);
+
+        if (addToBus)
+        {
+            voice.bus.addFromWithRamp(channel, 0, ring + readStart, firstRead, startGain, splitGain);
+            voice.bus.addFromWithRamp(channel, firstRead, ring, numSamples - firstRead, splitGain, endGain);
+        }
+        else
+        {
+            voice.bus.copyFromWithRamp(channel, 0, ring + readStart, firstRead, startGain, splitGain);
+            voice.bus.copyFromWithRamp(channel, firstRead, ring, numSamples - firstRead, splitGain, endGain);
+        }
+    }
+
+    void DeckMixer::renderVoices(int numSamples)
+    {
+        const int numVoices = (int)activeList->voices.size();
+        const bool inParallel = parallelRendering.load(std::memory_order_relaxed) && !workers.empty()
+                                 && numVoices >= minParallelVoices && numSamples >= minParallelSamples;
+
+        if (!inParallel)
+        {
+            for (const auto& voice : activeList->voices)
+                voice->source->getNextAudioBlock(juce::AudioSourceChannelInfo(&voice->bus, 0, numSamples));
+
+            return;
+        }
+
+        jobList = activeList;
+        jobSamples = numSamples;
+        voicesRemaining.store(numVoices, std::memory_order_relaxed);
+
+        // The count travels with every claim, so a worker still finishing off the last
+        // block can't claim anything from this one by mistake
+        claims.store((juce::uint64)numVoices << 32, std::memory_order_release);
+
+        for (int i = 0; i < juce::jmin((int)workers.size(), numVoices - 1); ++i)
+            workers[(size_t)i]->wake();
+
+        // The audio thread claims voices as well, so every voice a worker hasn't got to
+        // yet, all of them if the workers are slow to wake, is rendered right here
+        renderClaimedVoices();
+
+        // All that can be left is voices a worker has claimed and is in the middle of, so
+        // this waits for one voice's render at most. The workers run at the audio thread's
+        // priority and a claimed voice is already rendering, so yielding rather than
+        // blocking is bounded by that render, and doesn't hand the core to anything slower.
+        while (voicesRemaining.load(std::memory_order_acquire) > 0)
+            juce::Thread::yield();
+    }
+
+    void DeckMixer::renderClaimedVoices() noexcept
+    {
+        for (;;)
+        {
+            const auto claim = claims.fetch_add(1, std::memory_order_acq_rel);
+            const auto index = (juce::uint32)claim;
+
+            if (index >= (juce::uint32)(claim >> 32))
+                return;
+
+            auto& voice = *jobList->voices[index];
+            voice.source->getNextAudioBlock(juce::AudioSourceChannelInfo(&voice.bus, 0, jobSamples));
+
+            voicesRemaining.fetch_sub(1, std::memory_order_release);
+        }
+    }
+}
@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    DeckMixer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterRamp.h"
+#include "LevelMeter.h"
+#include "RealtimeSemaphore.h"
+
+namespace OtoDecksAudio
+{
+    // Sums any number of decks, samplers or other sources into the output. Every voice
+    // renders into a bus buffer of its own, allocated ahead of time, and the buses are
+    // added up with vectorized adds.
+    //
+    // Voices are added and removed on the message thread without the audio thread ever
+    // taking a lock: each change publishes a fresh list of voices, which the audio thread
+    // swaps in at the start of a block, handing the old one back to be freed here.
+    //
+    // Each voice goes through a channel strip on its way in: a trim, a channel fader and
+    // a crossfader side. Their combined gain glides to each new setting and is applied
+    // while the bus is being added in, so it costs no extra pass over the audio.
+    //
+    // On devices with a second stereo pair, outputs 3 and 4 carry a headphone cue bus.
+    // Any voice can be cued (PFL, after the trim but before the fader and crossfader),
+    // and the headphones hear a blend of the cue and the master. The cue is summed from
+    // the same buses as the master in the same pass, so no voice is rendered twice.
+    //
+    // With enough voices and long enough blocks, the voices can be rendered in parallel on
+    // worker threads. The audio thread takes a share of the work itself and waits for the
+    // rest before summing, so the output is the same either way.
+    class DeckMixer : public juce::AudioSource,
+                      private juce::Timer
+    {
+    public:
+        DeckMixer();
+        ~DeckMixer() override;
+
+        // Message thread. The source is prepared if the mixer already is, and is rendered
+        // from the next block on. The mixer doesn't own it.
+        void addVoice(juce::AudioSource* source);
+
+        // Message thread. The source stops being rendered from the next block on; keep it
+        // alive until isUpdatePending returns false.
+        void removeVoice(juce::AudioSource* source);
+
+        int getNumVoices() const;
+
+        enum class CrossfaderSide
+        {
+            thru,   // unaffected by the crossfader
+            left,
+            right
+        };
+
+        enum class CrossfaderCurve
+        {
+            linear,         // each side fades in a straight line, dipping 6 dB in the middle
+            constantPower,  // sine and cosine, so the mix stays as loud across the travel
+            sharpCut        // both sides at full level until the last few percent, for scratching
+        };
+
+        // Message thread. Ignored for sources that aren't voices.
+        void setChannelFader(juce::AudioSource* source, float gain);
+        void setChannelTrim(juce::AudioSource* source, float decibels);
+        void setCrossfaderSide(juce::AudioSource* source, CrossfaderSide side);
+
+        // Message thread. How far the voice runs behind its input, from plugins and the
+        // like. Every other voice is delayed to match the latest one, up to
+        // maxCompensationSeconds, so the decks stay lined up.
+        void setVoiceLatency(juce::AudioSource* source, int samples);
+
+        static constexpr double maxCompensationSeconds = 1.0;
+
+        // Message thread. Measures what the voice sends in, after its trim and before its
+        // fader, or nothing when meter is nullptr. The meter is prepared here and has to
+        // outlive the voice.
+        void setVoiceMeter(juce::AudioSource* source, LevelMeter* meter);
+
+        // 0 is hard left, 1 hard right
+        void setCrossfader(float position) noexcept { crossfader = juce::jlimit(0.0f, 1.0f, position); }
+        float getCrossfader() const noexcept { return crossfader.load(); }
+
+        void setCrossfaderCurve(CrossfaderCurve curve) noexcept { crossfaderCurve = curve; }
+        CrossfaderCurve getCrossfaderCurve() const noexcept { return crossfaderCurve.load(); }
+
+        // Gain of a side at a crossfader position
+        static float getCrossfaderGain(CrossfaderCurve curve, CrossfaderSide side, float position) noexcept;
+
+        // Message thread. Sends the voice to the headphones before its fader.
+        void setCue(juce::AudioSource* source, bool shouldCue);
+        bool isCued(juce::AudioSource* source) const;
+
+        // 0 is cue only, 1 is master only
+        void setCueMix(float mix) noexcept { cueMix = juce::jlimit(0.0f, 1.0f, mix); }
+        float getCueMix() const noexcept { return cueMix.load(); }
+
+        void setHeadphoneLevel(float gain) noexcept { headphoneLevel = juce::jlimit(0.0f, 1.0f, gain); }
+        float getHeadphoneLevel() const noexcept { return headphoneLevel.load(); }
+
+        // The first of the outputs the cue bus goes to; devices with fewer get no cue
+        static constexpr int firstCueChannel = 2;
+
+        static constexpr float minTrimDecibels = -12.0f;
+        static constexpr float maxTrimDecibels = 12.0f;
+
+        // True until the audio thread has picked up the last add or remove
+        bool isUpdatePending() const noexcept { return pendingList.load() != nullptr || retiredList.load() != nullptr; }
+
+        // Message thread. Renders voices on worker threads when there are at least
+        // minParallelVoices of them and blocks of at least minParallelSamples. Off by
+        // default, and no worker threads run until it's turned on.
+        void setParallelRendering(bool shouldRenderInParallel);
+        bool isRenderingInParallel() const noexcept { return parallelRendering.load(); }
+
+        // Two decks are worth splitting: with key lock and plugins each can cost a good
+        // share of a block, and one renders on a worker while the other renders here
+        static constexpr int minParallelVoices = 2;
+        static constexpr int minParallelSamples = 256;
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+        void releaseResources() override;
+
+    private:
+        struct Voice
+        {
+            juce::AudioSource* source = nullptr;
+            juce::AudioBuffer<float> bus;
+
+            // Set on the message thread
+            std::atomic<int> latency { 0 };
+            std::atomic<float> fader { 1.0f };
+            std::atomic<float> trim { 1.0f };
+            std::atomic<CrossfaderSide> side { CrossfaderSide::thru };
+            std::atomic<bool> cue { false };
+            std::atomic<LevelMeter*> meter { nullptr };
+
+            // Audio thread only, once the voice is live
+            ParameterRamp gain;
+            ParameterRamp cueGain;
+            juce::AudioBuffer<float> compensationLine;
+            int compensationWrite = 0;
+            int compensationDelay = 0;
+        };
+
+        // What the audio thread renders, shared with the message thread's copy so buses
+        // aren't reallocated on every change
+        struct VoiceList
+        {
+            std::vector<std::shared_ptr<Voice>> voices;
+        };
+
+        class Worker;
+
+        Voice* findVoice(juce::AudioSource* source) const;
+        void publish();
+        void timerCallback() override;
+
+        void prepareVoice(Voice& voice);
+        static void delayVoice(Voice& voice, int delay, int numSamples) noexcept;
+        static void readDelayed(Voice& voice, int channel, int delay, int numSamples,
+                                float startGain, float endGain, bool addToBus) noexcept;
+
+        void renderVoices(int numSamples);
+        void renderClaimedVoices() noexcept;
+
+        // Channels on every bus; outputs beyond these are left silent
+        static constexpr int numBusChannels = 2;
+
+        // How long a channel strip's gain takes to follow a fader
+        static constexpr double channelRampSeconds = 0.01;
+
+        // How far from either end the sharp cut curve closes
+        static constexpr float sharpCutWidth = 0.05f;
+
+        std::atomic<float> crossfader { 0.5f };
+        std::atomic<CrossfaderCurve> crossfaderCurve { CrossfaderCurve::constantPower };
+        std::atomic<float> cueMix { 0.0f };
+        std::atomic<float> headphoneLevel { 1.0f };
+
+        // How much of the master the headphones hear. The cue's share is folded into each
+        // voice's cueGain instead. Audio thread only.
+        ParameterRamp masterInCue;
+
+        // Owned by the message thread, and locked against the device thread's prepareToPlay
+        juce::CriticalSection lock;
+        std::vector<std::shared_ptr<Voice>> voices;
+        int busLength = 0;
+        double currentSampleRate = 0.0;
+
+        // List handover, as for tracks: the audio thread swaps in pendingList at the start
+        // of a block and hands the old list back through retiredList
+        std::atomic<VoiceList*> pendingList { nullptr };
+        std::atomic<VoiceList*> retiredList { nullptr };
+        VoiceList* activeList = nullptr;
+
+        // The block being rendered in parallel. Voices are claimed one at a time by counting
+        // up the low half of claims, whose high half holds the number of voices, and the
+        // block is done once voicesRemaining reaches zero.
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<bool> parallelRendering { false };
+        const VoiceList* jobList = nullptr;
+        int jobSamples = 0;
+        std::atomic<juce::uint64> claims { 0 };
+        std::atomic<int> voicesRemaining { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckMixer)
+    };
+}
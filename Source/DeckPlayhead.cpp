@@ -0,0 +1,803 @@
+/*
+  ==============================================================================
+
+    DeckPlayhead.cpp
+
+  ==============================================================================
+*/
+
+#include "DeckPlayhead.h"
+
+namespace OtoDecksAudio
+{
+    void DeckPlayhead::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+    {
+        deviceSampleRate = sampleRate;
+        Resampler::prepare();
+
+        // Big enough for a few blocks at top speed; longer blocks are rendered in chunks
+        window.setSize(maxWindowChannels, juce::jmax(4096, samplesPerBlockExpected * 8));
+
+        stretcher.prepare(sampleRate, maxWindowChannels);
+        stretching = false;
+
+        // Equal-power curves for the join wherever playback jumps: loop wraps, seeks and rolls
+        const int crossfadeSamples = juce::jmax(1, juce::roundToInt(jumpCrossfadeSeconds * sampleRate));
+        jumpTail.setSize(maxWindowChannels, crossfadeSamples);
+        jumpFadeIn.resize((size_t)crossfadeSamples);
+        jumpFadeOut.resize((size_t)crossfadeSamples);
+
+        for (int i = 0; i < crossfadeSamples; ++i)
+        {
+            const double angle = juce::MathConstants<double>::halfPi * (i + 0.5) / crossfadeSamples;
+            jumpFadeIn[(size_t)i] = (float)std::sin(angle);
+            jumpFadeOut[(size_t)i] = (float)std::cos(angle);
+        }
+
+        jumpCrossfadeRemaining = 0;
+
+        // Everything scheduled was timed against the old clock
+        sampleClock = 0;
+        numScheduled = 0;
+    }
+
+    void DeckPlayhead::setTrack(TrackSamples* newSamples, MemoryAudioSource* newUnitySource, double newSourceSampleRate)
+    {
+        // Commands still queued were sent for the outgoing track, and mustn't reach this one
+        applyCommands(samples != nullptr ? (double)samples->getNumSamples() : 0.0);
+
+        samples = newSamples;
+        unitySource = newUnitySource;
+        sourceSampleRate = newSourceSampleRate;
+
+        position = 0.0;
+        currentRate = 0.0;
+        braking = false;
+        playing = nextTrackPlaying.load();
+        reversed = false;
+        stretcher.reset();
+
+        // Loops belong to the track they were set on
+        looping = false;
+        insideLoop = false;
+        rolling = false;
+        jumpCrossfadeRemaining = 0;
+
+        finished = false;
+        buffering = false;
+        ++tracksReceived;
+        publishState();
+    }
+
+    void DeckPlayhead::renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+    {
+        const bool hasTrack = samples != nullptr && samples->getNumSamples() > 0 && samples->getNumChannels() > 0;
+        const double numFrames = hasTrack ? (double)samples->getNumSamples() : 0.0;
+        const juce::int64 blockEnd = sampleClock + bufferToFill.numSamples;
+
+        applyCommands(numFrames);
+
+        // Render up to each scheduled command that falls inside this block, apply it on
+        // its exact sample, then carry on from there
+        for (int done = 0; done < bufferToFill.numSamples;)
+        {
+            const int next = findNextScheduled(blockEnd);
+            int segmentEnd = next < 0 ? bufferToFill.numSamples
+                                      : (int)juce::jlimit((juce::int64)done, (juce::int64)bufferToFill.numSamples,
+                                                          scheduled[(size_t)next].time - sampleClock);
+
+            // Segments also end wherever the playhead reaches a loop's edge, so the wrap
+            // lands on its exact sample without checking every sample for it
+            if (hasTrack)
+                segmentEnd = done + followLoop(segmentEnd - done);
+
+            if (segmentEnd > done)
+            {
+                const juce::AudioSourceChannelInfo segment(bufferToFill.buffer, bufferToFill.startSample + done, segmentEnd - done);
+
+                if (hasTrack)
+                    renderSegment(segment);
+                else
+                    segment.clearActiveBufferRegion();
+
+                done = segmentEnd;
+            }
+
+            if (next >= 0)
+            {
+                applyCommand(scheduled[(size_t)next], numFrames);
+                scheduled[(size_t)next] = scheduled[(size_t)--numScheduled];
+            }
+        }
+
+        sampleClock = blockEnd;
+        publishState();
+    }
+
+    int DeckPlayhead::findNextScheduled(juce::int64 blockEnd) const noexcept
+    {
+        // Earliest first; a tie goes to whichever was sent first
+        int next = -1;
+
+        for (int i = 0; i < numScheduled; ++i)
+        {
+            const auto& command = scheduled[(size_t)i];
+
+            if (command.time < blockEnd
+                && (next < 0 || command.time < scheduled[(size_t)next].time
+                    || (command.time == scheduled[(size_t)next].time && (juce::int32)(command.id - scheduled[(size_t)next].id) < 0)))
+                next = i;
+        }
+
+        return next;
+    }
+
+    int DeckPlayhead::followLoop(int maxSamples)
+    {
+        if (looping)
+        {
+            const bool inside = position >= loopStart && position < loopEnd;
+
+            // Only a playhead that was already inside wraps; one that has jumped out
+            // plays on until it comes back in
+            if (insideLoop && !inside)
+            {
+                startJumpCrossfade(position);
+                position = wrapIntoLoop(position);
+            }
+
+            insideLoop = position >= loopStart && position < loopEnd;
+
+            const double targetRate = getTargetRate();
+            const double fastest = juce::jmax(std::abs(currentRate), std::abs(targetRate)) * sourceSampleRate / deviceSampleRate;
+
+            if (insideLoop && fastest > 0.0)
+            {
+                // Stop short of anywhere the playhead could reach an edge at the fastest it
+                // might move. At a steady rate that is exactly the sample it gets there.
+                double limit = (double)maxSamples;
+
+                if (juce::jmax(currentRate, targetRate) > 0.0)
+                    limit = juce::jmin(limit, std::ceil((loopEnd - position) / fastest));
+
+                if (juce::jmin(currentRate, targetRate) < 0.0)
+                    limit = juce::jmin(limit, std::floor((position - loopStart) / fastest) + 1.0);
+
+                maxSamples = (int)limit;
+            }
+        }
+
+        if (jumpCrossfadeRemaining > 0)
+            maxSamples = juce::jmin(maxSamples, jumpCrossfadeRemaining);
+
+        return maxSamples;
+    }
+
+    double DeckPlayhead::wrapIntoLoop(double newPosition) const noexcept
+    {
+        const double length = loopEnd - loopStart;
+        const double offset = std::fmod(newPosition - loopStart, length);
+        return loopStart + (offset < 0.0 ? offset + length : offset);
+    }
+
+    void DeckPlayhead::setLoopPoints(double start, double end, double numFrames)
+    {
+        const bool wasInside = looping && insideLoop;
+
+        loopStart = juce::jlimit(0.0, numFrames, start);
+        loopEnd = juce::jlimit(loopStart, numFrames, end);
+        looping = loopEnd > loopStart;
+
+        if (looping && wasInside && position >= loopEnd)
+        {
+            startJumpCrossfade(position);
+            position = wrapIntoLoop(position);
+        }
+
+        insideLoop = looping && position >= loopStart && position < loopEnd;
+    }
+
+    void DeckPlayhead::startJumpCrossfade(double tailPosition) noexcept
+    {
+        jumpTailPosition = tailPosition;
+        jumpCrossfadeRemaining = (int)jumpFadeIn.size();
+    }
+
+    void DeckPlayhead::renderJumpTail(int numSamples, int numOutputChannels, double startIncrement, double endIncrement)
+    {
+        // The tail plays on from where the playhead jumped from, through the same resampler
+        jumpTail.setSize(juce::jmin(numOutputChannels, maxWindowChannels), numSamples, false, false, true);
+
+        const double headPosition = position;
+        position = jumpTailPosition;
+        renderInterpolated(juce::AudioSourceChannelInfo(&jumpTail, 0, numSamples), startIncrement, endIncrement);
+        jumpTailPosition = position;
+        position = headPosition;
+    }
+
+    void DeckPlayhead::mixJumpTail(const juce::AudioSourceChannelInfo& segment)
+    {
+        const int numSamples = segment.numSamples;
+        const auto fadeOffset = jumpFadeIn.size() - (size_t)jumpCrossfadeRemaining;
+
+        for (int channel = 0; channel < segment.buffer->getNumChannels(); ++channel)
+        {
+            float* dest = segment.buffer->getWritePointer(channel, segment.startSample);
+
+            juce::FloatVectorOperations::multiply(dest, jumpFadeIn.data() + fadeOffset, numSamples);
+            juce::FloatVectorOperations::addWithMultiply(dest, jumpTail.getReadPointer(channel % jumpTail.getNumChannels()),
+                                                         jumpFadeOut.data() + fadeOffset, numSamples);
+        }
+
+        jumpCrossfadeRemaining -= numSamples;
+    }
+
+    void DeckPlayhead::renderSegment(const juce::AudioSourceChannelInfo& segment)
+    {
+        const double numFrames = (double)samples->getNumSamples();
+        const double segmentSeconds = segment.numSamples / deviceSampleRate;
+        const double segmentStart = position;
+
+        // Work out where the rate should be by the end of this segment
+        const double startRate = currentRate;
+        double endRate = getTargetRate();
+
+        if (braking && !scratching)
+        {
+            const double maxChange = brakeRatePerSecond * segmentSeconds;
+            endRate = startRate > 0.0 ? juce::jmax(0.0, startRate - maxChange)
+                                      : juce::jmin(0.0, startRate + maxChange);
+
+            if (endRate == 0.0)
+            {
+                braking = false;
+                playing = false;
+            }
+        }
+
+        // Changes of rate while already moving glide there at a steady pace, worked out
+        // afresh whenever the target moves so every change takes the same time
+        const bool gliding = !braking && !scratching && startRate != 0.0 && endRate != 0.0;
+
+        if (gliding)
+        {
+            if (endRate != rateRampTarget)
+            {
+                rateRampTarget = endRate;
+                rateRampStep = std::abs(endRate - startRate) / juce::jmax(1.0, rateRampSeconds.load() * deviceSampleRate);
+            }
+
+            const double maxChange = rateRampStep * segment.numSamples;
+            endRate = juce::jlimit(startRate - maxChange, startRate + maxChange, endRate);
+        }
+        else
+        {
+            rateRampTarget = 0.0;
+        }
+
+        currentRate = endRate;
+
+        // Rates are relative to the track, so fold in any difference between file and device rate
+        const double sampleRateRatio = sourceSampleRate / deviceSampleRate;
+        const double startIncrement = startRate * sampleRateRatio;
+        const double endIncrement = endRate * sampleRateRatio;
+
+        // Key lock only stretches steady playback in one direction. Anything else goes
+        // through the resampler, and the stretcher starts afresh when it's next needed.
+        const bool shouldStretch = keyLock && !scratching && !braking
+                                    && startIncrement * endIncrement > 0.0
+                                    && std::abs(sampleRateRatio) <= TimeStretcher::maxSampleRateRatio;
+
+        if (stretching && !shouldStretch)
+            stretcher.reset();
+
+        stretching = shouldStretch;
+
+        // A streamed track only holds a window of the file around the playhead. Keep it
+        // following along, and wait for it to catch up if the playhead has left it.
+        samples->setPlaybackPosition(playheadId, (juce::int64)position, endIncrement < 0.0 || (endIncrement == 0.0 && startIncrement < 0.0));
+
+        // Stretched grains read a little way either side of the playhead as well
+        const double grainReach = stretching ? stretcher.getReach(sampleRateRatio) : 0.0;
+        const double reach = juce::jmax(std::abs(startIncrement), std::abs(endIncrement)) * segment.numSamples + 2.0 + grainReach;
+        const double lowest = juce::jmin(startIncrement, endIncrement) < 0.0 ? position - reach : position - grainReach;
+        const double highest = juce::jmax(startIncrement, endIncrement) > 0.0 ? position + reach : position + 2.0 + grainReach;
+        const bool isAvailable = samples->isAvailable((juce::int64)juce::jlimit(0.0, numFrames, std::floor(lowest)),
+                                                      (juce::int64)juce::jlimit(0.0, numFrames, std::ceil(highest)));
+        buffering = !isAvailable;
+
+        if ((startRate == 0.0 && endRate == 0.0) || !isAvailable)
+        {
+            segment.clearActiveBufferRegion();
+
+            // Hold still while buffering, then fade back in once the audio is there
+            currentRate = 0.0;
+            jumpCrossfadeRemaining = 0;
+            return;
+        }
+
+        // Stretched grains overlap their own way across a jump
+        const bool crossfadingJump = jumpCrossfadeRemaining > 0 && !stretching;
+
+        if (crossfadingJump)
+            renderJumpTail(segment.numSamples, segment.buffer->getNumChannels(), startIncrement, endIncrement);
+        else
+            jumpCrossfadeRemaining = 0;
+
+        const bool isUnityRate = startIncrement == endIncrement && std::abs(startIncrement) == 1.0;
+        const bool isOnSample = position == std::floor(position) && position >= 0.0 && position < numFrames;
+
+        if (stretching)
+            renderStretched(segment, startIncrement, endIncrement, sampleRateRatio);
+        else if (isUnityRate && isOnSample && unitySource != nullptr)
+            renderUnityRate(segment, startIncrement < 0.0);
+        else
+            renderInterpolated(segment, startIncrement, endIncrement);
+
+        if (crossfadingJump)
+            mixJumpTail(segment);
+
+        if (rolling)
+            rollPosition += position - segmentStart;
+
+        // Fade in and out of standstill so the waveform never jumps to or from silence
+        if (startRate == 0.0)
+            segment.buffer->applyGainRamp(segment.startSample, segment.numSamples, 0.0f, 1.0f);
+        else if (endRate == 0.0)
+            segment.buffer->applyGainRamp(segment.startSample, segment.numSamples, 1.0f, 0.0f);
+
+        if (declickRemaining > 0)
+        {
+            const int numToFade = juce::jmin(declickRemaining, segment.numSamples);
+            const auto fadeStart = 1.0f - (float)declickRemaining / declickSamples;
+            const auto fadeEnd = 1.0f - (float)(declickRemaining - numToFade) / declickSamples;
+
+            segment.buffer->applyGainRamp(segment.startSample, numToFade, fadeStart, fadeEnd);
+            declickRemaining -= numToFade;
+        }
+
+        if (position >= numFrames || position < 0.0)
+        {
+            position = juce::jlimit(0.0, numFrames, position);
+
+            // Scratching past an edge just holds the record there
+            if (!scratching)
+            {
+                currentRate = 0.0;
+                braking = false;
+                playing = false;
+                finished = true;
+            }
+        }
+    }
+
+    void DeckPlayhead::renderUnityRate(const juce::AudioSourceChannelInfo& bufferToFill, bool backwards)
+    {
+        // Going backwards the source's position is the boundary after the next sample to play
+        const auto boundaryOffset = backwards ? 1 : 0;
+
+        unitySource->setReversed(backwards);
+        unitySource->setNextReadPosition((juce::int64)position + boundaryOffset);
+        unitySource->getNextAudioBlock(bufferToFill);
+
+        position = (double)(unitySource->getNextReadPosition() - boundaryOffset);
+    }
+
+    void DeckPlayhead::renderInterpolated(const juce::AudioSourceChannelInfo& bufferToFill, double startIncrement, double endIncrement)
+    {
+        const int numOutputChannels = bufferToFill.buffer->getNumChannels();
+        const int numChannels = juce::jmin(numOutputChannels, samples->getNumChannels(), maxWindowChannels);
+        const int numSamples = bufferToFill.numSamples;
+        const int windowLength = window.getNumSamples();
+        const auto quality = resamplerQuality;
+
+        // Ramp the increment across the block so rate changes glide instead of stepping
+        double increment = startIncrement;
+        const double incrementStep = (endIncrement - startIncrement) / numSamples;
+
+        // Stored samples may be in a compact format, so each chunk of output first converts
+        // the stretch of track it covers into the window, then resamples from there
+        const double fastestIncrement = juce::jmax(std::abs(startIncrement), std::abs(endIncrement), 1.0);
+        const int samplesBefore = Resampler::getSamplesBefore(quality, fastestIncrement);
+        const int samplesAfter = Resampler::getSamplesAfter(quality, fastestIncrement);
+        const int maxChunk = juce::jmax(1, (int)((windowLength - samplesBefore - samplesAfter - 2) / fastestIncrement));
+
+        for (int chunkStart = 0; chunkStart < numSamples;)
+        {
+            const int chunkLength = juce::jmin(maxChunk, numSamples - chunkStart);
+
+            // Trace the chunk once to find how far it reaches either way, and where it ends
+            double lowest = position, highest = position;
+            double endPosition = position, nextIncrement = increment;
+
+            for (int i = 0; i < chunkLength; ++i)
+            {
+                lowest = juce::jmin(lowest, endPosition);
+                highest = juce::jmax(highest, endPosition);
+                endPosition += nextIncrement;
+                nextIncrement += incrementStep;
+            }
+
+            const auto first = (juce::int64)std::floor(lowest) - samplesBefore;
+            const auto last = (juce::int64)std::floor(highest) + samplesAfter;
+            fillWindow(first, (int)juce::jmin((juce::int64)windowLength, last + 1 - first), numChannels);
+
+            for (int channel = 0; channel < numOutputChannels; ++channel)
+                Resampler::process(quality, window.getReadPointer(channel % numChannels),
+                                   bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample + chunkStart),
+                                   chunkLength, position - (double)windowStart, increment, incrementStep);
+
+            position = endPosition;
+            increment = nextIncrement;
+            chunkStart += chunkLength;
+        }
+    }
+
+    void DeckPlayhead::renderStretched(const juce::AudioSourceChannelInfo& bufferToFill, double startIncrement, double endIncrement, double sampleRateRatio)
+    {
+        const int numSamples = bufferToFill.numSamples;
+        const double incrementStep = (endIncrement - startIncrement) / numSamples;
+
+        stretcher.process(*samples, sampleRateRatio, *bufferToFill.buffer, bufferToFill.startSample, numSamples,
+                          position, startIncrement, incrementStep);
+
+        // The playhead itself moves exactly as it would through the resampler
+        position += startIncrement * numSamples + incrementStep * numSamples * (numSamples - 1) * 0.5;
+    }
+
+    void DeckPlayhead::fillWindow(juce::int64 firstFrame, int numWindowFrames, int numChannels)
+    {
+        // Anything before the start or after the end of the track reads as silence
+        const juce::int64 numFrames = samples->getNumSamples();
+        const juce::int64 readStart = juce::jlimit((juce::int64)0, numFrames, firstFrame);
+        const juce::int64 readEnd = juce::jlimit((juce::int64)0, numFrames, firstFrame + numWindowFrames);
+
+        windowStart = firstFrame;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* dest = window.getWritePointer(channel);
+
+            if (readEnd > readStart)
+            {
+                juce::FloatVectorOperations::clear(dest, (int)(readStart - firstFrame));
+                samples->read(channel, readStart, dest + (readStart - firstFrame), (int)(readEnd - readStart));
+                juce::FloatVectorOperations::clear(dest + (readEnd - firstFrame), (int)(firstFrame + numWindowFrames - readEnd));
+            }
+            else
+            {
+                juce::FloatVectorOperations::clear(dest, numWindowFrames);
+            }
+        }
+    }
+
+    double DeckPlayhead::getTargetRate() const noexcept
+    {
+        if (scratching)
+            return scratchRate.load();
+
+        if (!playing)
+            return 0.0;
+
+        const double direction = reversed ? -1.0 : 1.0;
+        return juce::jlimit(-maxRate, maxRate, direction * speed.load() + nudge.load());
+    }
+
+    void DeckPlayhead::applyCommands(double numFrames)
+    {
+        commands.drain([this, numFrames] (const DeckCommand& command)
+        {
+            lastReceivedCommand = command.id;
+
+            // Anything due later waits for its sample. If there's no room left to hold it,
+            // doing it early beats losing it.
+            if (command.time > sampleClock && numScheduled < maxScheduled)
+                scheduled[(size_t)numScheduled++] = command;
+            else
+                applyCommand(command, numFrames);
+        });
+    }
+
+    void DeckPlayhead::applyCommand(const DeckCommand& command, double numFrames)
+    {
+        switch (command.type)
+        {
+            case DeckCommand::Type::Play:
+                playing = true;
+                braking = false;
+
+                // Timed starts skip the run-up so they stay on the beat
+                if (command.time >= 0 && !scratching && currentRate == 0.0)
+                {
+                    currentRate = getTargetRate();
+                    declickRemaining = declickSamples;
+                }
+                break;
+
+            case DeckCommand::Type::Stop:
+                playing = false;
+                break;
+
+            case DeckCommand::Type::SetReversed:
+                reversed = command.value != 0.0;
+                break;
+
+            case DeckCommand::Type::Seek:
+                if (currentRate != 0.0)
+                    startJumpCrossfade(position);
+
+                position = juce::jmin(command.value, numFrames);
+                finished = false;
+                stretcher.reset();
+                insideLoop = looping && position >= loopStart && position < loopEnd;
+                break;
+
+            case DeckCommand::Type::Brake:
+                braking = true;
+                brakeRatePerSecond = juce::jmax(std::abs(currentRate), 1.0) / juce::jmax(command.value, 0.01);
+                break;
+
+            case DeckCommand::Type::Spinback:
+                currentRate = spinbackRate;
+                braking = true;
+                brakeRatePerSecond = std::abs(spinbackRate) / juce::jmax(command.value, 0.01);
+                break;
+
+            case DeckCommand::Type::BeginScratch:
+                scratching = true;
+                break;
+
+            case DeckCommand::Type::EndScratch:
+                scratching = false;
+                break;
+
+            case DeckCommand::Type::SetQuality:
+                resamplerQuality = (Resampler::Quality)(int)command.value;
+                break;
+
+            case DeckCommand::Type::SetKeyLock:
+                keyLock = command.value != 0.0;
+                break;
+
+            case DeckCommand::Type::SetLoop:
+                setLoopPoints(command.value, command.loopEnd, numFrames);
+                break;
+
+            case DeckCommand::Type::ClearLoop:
+                looping = false;
+                insideLoop = false;
+                rolling = false;
+                break;
+
+            case DeckCommand::Type::BeginLoopRoll:
+                if (!rolling)
+                    rollPosition = position;
+
+                rolling = true;
+                setLoopPoints(command.value, command.loopEnd, numFrames);
+                break;
+
+            case DeckCommand::Type::EndLoopRoll:
+                if (rolling)
+                {
+                    rolling = false;
+                    looping = false;
+                    insideLoop = false;
+
+                    startJumpCrossfade(position);
+                    position = juce::jlimit(0.0, numFrames, rollPosition);
+                }
+                break;
+        }
+    }
+
+    void DeckPlayhead::publishState()
+    {
+        State state;
+        state.position = position;
+        state.rate = currentRate;
+        state.playing = playing;
+        state.reversed = reversed;
+        state.finished = finished;
+        state.buffering = buffering;
+        state.looping = looping;
+        state.loopStart = loopStart;
+        state.loopEnd = loopEnd;
+        state.lastCommand = lastReceivedCommand;
+        state.tracksReceived = tracksReceived;
+        state.sampleClock = sampleClock;
+
+        publishedState.write(state);
+    }
+
+    //==============================================================================
+    void DeckPlayhead::send(DeckCommand::Type type, double value, juce::int64 sampleTime, double end)
+    {
+        const DeckCommand command { type, value, sampleTime, ++lastSentCommand, end };
+
+        // Only fills up if the audio device has stopped calling back
+        const bool wasQueued = commands.push(command);
+        jassert(wasQueued);
+        juce::ignoreUnused(wasQueued);
+    }
+
+    bool DeckPlayhead::hasApplied(juce::uint32 command) const noexcept
+    {
+        // Ids wrap around, so compare the distance between them
+        return (juce::int32)(getState().lastCommand - command) >= 0;
+    }
+
+    void DeckPlayhead::expectTrack(bool startPlaying)
+    {
+        ++tracksExpected;
+        requestedPlaying = startPlaying;
+        requestedReversed = false;
+        requestedPosition = 0.0;
+        nextTrackPlaying = startPlaying;
+    }
+
+    void DeckPlayhead::setPlaying(bool shouldPlay)
+    {
+        requestedPlaying = shouldPlay;
+        nextTrackPlaying = shouldPlay;
+        send(shouldPlay ? DeckCommand::Type::Play : DeckCommand::Type::Stop);
+        playCommand = lastSentCommand;
+    }
+
+    bool DeckPlayhead::isPlaying() const noexcept
+    {
+        // Once the audio thread has seen the request, it knows better: a brake or the end
+        // of the track may have stopped it since
+        return hasApplied(playCommand) && !isAwaitingTrack() ? getState().playing : requestedPlaying;
+    }
+
+    void DeckPlayhead::setPlayingAt(bool shouldPlay, juce::int64 sampleTime)
+    {
+        // Not a request for right now, so the getters keep reporting the deck's real state
+        send(shouldPlay ? DeckCommand::Type::Play : DeckCommand::Type::Stop, 0.0, sampleTime);
+    }
+
+    DeckPlayhead::Timing DeckPlayhead::getTiming() const noexcept
+    {
+        const auto& state = getState();
+        return { state.position, state.rate, state.sampleClock };
+    }
+
+    void DeckPlayhead::setSpeed(double newSpeed)
+    {
+        speed = juce::jlimit(0.0, maxRate, newSpeed);
+    }
+
+    void DeckPlayhead::setQuality(Resampler::Quality newQuality)
+    {
+        requestedQuality = newQuality;
+        send(DeckCommand::Type::SetQuality, (double)(int)newQuality);
+    }
+
+    void DeckPlayhead::setKeyLock(bool shouldLockKey)
+    {
+        requestedKeyLock = shouldLockKey;
+        send(DeckCommand::Type::SetKeyLock, shouldLockKey ? 1.0 : 0.0);
+    }
+
+    void DeckPlayhead::setReversed(bool shouldPlayBackwards)
+    {
+        requestedReversed = shouldPlayBackwards;
+        send(DeckCommand::Type::SetReversed, shouldPlayBackwards ? 1.0 : 0.0);
+        reverseCommand = lastSentCommand;
+    }
+
+    bool DeckPlayhead::isReversed() const noexcept
+    {
+        return hasApplied(reverseCommand) && !isAwaitingTrack() ? getState().reversed : requestedReversed;
+    }
+
+    void DeckPlayhead::setPosition(double newPosition)
+    {
+        requestedPosition = juce::jmax(0.0, newPosition);
+        send(DeckCommand::Type::Seek, requestedPosition);
+        seekCommand = lastSentCommand;
+    }
+
+    void DeckPlayhead::setPositionAt(double newPosition, juce::int64 sampleTime)
+    {
+        send(DeckCommand::Type::Seek, juce::jmax(0.0, newPosition), sampleTime);
+    }
+
+    double DeckPlayhead::getPosition() const noexcept
+    {
+        // A seek that hasn't reached the audio thread yet is already where the playhead will be
+        return hasApplied(seekCommand) && !isAwaitingTrack() ? getState().position : requestedPosition;
+    }
+
+    bool DeckPlayhead::hasFinished() const noexcept
+    {
+        // A seek always brings the playhead back onto the track
+        return hasApplied(seekCommand) && !isAwaitingTrack() && getState().finished;
+    }
+
+    void DeckPlayhead::brake(double seconds)
+    {
+        send(DeckCommand::Type::Brake, juce::jmax(0.0, seconds));
+    }
+
+    void DeckPlayhead::spinback(double seconds)
+    {
+        send(DeckCommand::Type::Spinback, juce::jmax(0.0, seconds));
+    }
+
+    void DeckPlayhead::setNudge(double rateOffset)
+    {
+        nudge = rateOffset;
+    }
+
+    void DeckPlayhead::setScratchRate(double rate)
+    {
+        scratchRate = juce::jlimit(-maxRate, maxRate, rate);
+
+        if (!requestedScratching)
+        {
+            requestedScratching = true;
+            send(DeckCommand::Type::BeginScratch);
+        }
+    }
+
+    void DeckPlayhead::endScratch()
+    {
+        if (requestedScratching)
+        {
+            requestedScratching = false;
+            send(DeckCommand::Type::EndScratch);
+        }
+    }
+
+    void DeckPlayhead::setLoop(double start, double end)
+    {
+        // Whole samples keep looped playback at 1x on the direct path
+        requestedLoopStart = std::round(juce::jmax(0.0, start));
+        requestedLoopEnd = std::round(juce::jmax(0.0, end));
+        requestedLooping = requestedLoopEnd > requestedLoopStart;
+
+        send(DeckCommand::Type::SetLoop, requestedLoopStart, -1, requestedLoopEnd);
+        loopCommand = lastSentCommand;
+    }
+
+    void DeckPlayhead::clearLoop()
+    {
+        requestedLooping = false;
+        send(DeckCommand::Type::ClearLoop);
+        loopCommand = lastSentCommand;
+    }
+
+    void DeckPlayhead::beginLoopRoll(double start, double end)
+    {
+        requestedLoopStart = std::round(juce::jmax(0.0, start));
+        requestedLoopEnd = std::round(juce::jmax(0.0, end));
+        requestedLooping = requestedLoopEnd > requestedLoopStart;
+
+        send(DeckCommand::Type::BeginLoopRoll, requestedLoopStart, -1, requestedLoopEnd);
+        loopCommand = lastSentCommand;
+    }
+
+    void DeckPlayhead::endLoopRoll()
+    {
+        requestedLooping = false;
+        send(DeckCommand::Type::EndLoopRoll);
+        loopCommand = lastSentCommand;
+    }
+
+    bool DeckPlayhead::isLooping() const noexcept
+    {
+        return hasApplied(loopCommand) ? getState().looping : requestedLooping;
+    }
+
+    double DeckPlayhead::getLoopStart() const noexcept
+    {
+        return hasApplied(loopCommand) ? getState().loopStart : requestedLoopStart;
+    }
+
+    double DeckPlayhead::getLoopEnd() const noexcept
+    {
+        return hasApplied(loopCommand) ? getState().loopEnd : requestedLoopEnd;
+    }
+}
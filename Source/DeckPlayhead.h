@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+    DeckPlayhead.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MemoryAudioSource.h"
+#include "TrackSamples.h"
+#include "Resampler.h"
+#include "TimeStretcher.h"
+#include "DeckCommandQueue.h"
+#include "TripleBuffer.h"
+
+namespace OtoDecksAudio
+{
+    // A single playhead that moves through a decoded track at a signed, continuously
+    // variable rate. Negative rates play backwards, so reverse, scratching, brakes and
+    // nudges are all just rate changes; the position never has to be converted.
+    //
+    // Control calls come from the message thread. Actions are queued in order and
+    // applied by the audio thread at the start of the next block, while continuous
+    // values like speed are plain atomics where only the latest matters. The audio
+    // thread publishes its state back as a snapshot, and the getters answer with what
+    // was last asked for until the audio thread has caught up with it.
+    class DeckPlayhead
+    {
+    public:
+        // Fastest rate in either direction, as a multiple of normal speed
+        static constexpr double maxRate = 4.0;
+
+        DeckPlayhead() = default;
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+
+        // Message thread. The next track given to setTrack starts from the top, forwards,
+        // and playing or not; the getters report that from now until it arrives. The start
+        // travels with the track, so it can't land on the one being replaced.
+        void expectTrack(bool startPlaying);
+
+        // Audio thread only. Points the playhead at a new track and puts it in the state
+        // asked for by expectTrack. The unity source must read the same samples; it serves
+        // blocks played at exactly 1x.
+        void setTrack(TrackSamples* newSamples, MemoryAudioSource* newUnitySource, double newSourceSampleRate);
+
+        // Audio thread only. Applies any queued commands, then renders one block at the
+        // current rate. Without a track it only applies the commands and outputs silence.
+        void renderNextBlock(const juce::AudioSourceChannelInfo& bufferToFill);
+
+        void setPlaying(bool shouldPlay);
+        bool isPlaying() const noexcept;
+
+        // Starts or stops on an exact sample of the deck's sample clock. A start scheduled
+        // this way is at full speed from its first sample, to land exactly on the beat.
+        void setPlayingAt(bool shouldPlay, juce::int64 sampleTime);
+
+        // Moves the playhead on an exact sample of the deck's sample clock
+        void setPositionAt(double newPosition, juce::int64 sampleTime);
+
+        // Where the playhead was at the end of the last block, how fast it was moving and
+        // the sample clock at that moment, all from the same block. The sample clock counts
+        // output samples since prepareToPlay, so it runs alongside every other deck's.
+        struct Timing
+        {
+            double position = 0.0;
+            double rate = 0.0;
+            juce::int64 sampleClock = 0;
+        };
+
+        Timing getTiming() const noexcept;
+
+        // Playback speed as a positive multiple of normal speed
+        void setSpeed(double newSpeed);
+
+        // How long speed, nudge and direction changes take to glide to their new rate
+        // while playing. Zero jumps there within a block. Starts, stops, brakes and
+        // scratches keep their own timing.
+        void setRateRampTime(double seconds) { rateRampSeconds = juce::jmax(0.0, seconds); }
+
+        // How samples between the source's own are worked out when not playing at exactly 1x
+        void setQuality(Resampler::Quality newQuality);
+        Resampler::Quality getQuality() const noexcept { return requestedQuality; }
+
+        // With key lock on, speed changes the tempo but not the pitch. Scratches and brakes
+        // still change both, as they would on a turntable.
+        void setKeyLock(bool shouldLockKey);
+        bool isKeyLocked() const noexcept { return requestedKeyLock; }
+
+        // How far key-locked audio can be from the reported position, in seconds
+        double getKeyLockLatency() const noexcept { return stretcher.getLatencyInSamples() / deviceSampleRate; }
+
+        void setReversed(bool shouldPlayBackwards);
+        bool isReversed() const noexcept;
+
+        // Positions are in source samples on the forward timeline. Jumps while playing
+        // crossfade from the old position to the new one.
+        void setPosition(double newPosition);
+        double getPosition() const noexcept;
+
+        // True once the playhead has run off either end of the track
+        bool hasFinished() const noexcept;
+
+        // True while a streamed track hasn't caught up with the playhead yet, for example
+        // just after a seek outside its window. Playback holds its place until it has.
+        bool isBuffering() const noexcept { return getState().buffering; }
+
+        // The signed rate the playhead is moving at right now
+        double getCurrentRate() const noexcept { return getState().rate; }
+
+        // Slows down to a stop over the given time, like a turntable losing power
+        void brake(double seconds);
+
+        // Throws the platter backwards, then lets it come to a stop over the given time
+        void spinback(double seconds);
+
+        // Temporarily speeds up or slows down playback, like pushing a jog wheel
+        void setNudge(double rateOffset);
+
+        // While scratching, the hand sets the rate directly regardless of play state
+        void setScratchRate(double rate);
+        void endScratch();
+
+        // Loops between two positions in source samples, wrapping on the exact sample the
+        // playhead reaches either edge with a short equal-power crossfade across the join.
+        // A playhead outside the loop plays on as normal until it crosses into it, and a
+        // loop that shrinks behind the playhead takes it along to the same place in the loop.
+        void setLoop(double start, double end);
+        void clearLoop();
+
+        // Loops until the roll ends, then drops back to wherever the track would have got to
+        // without it. Ending a roll clears the loop.
+        void beginLoopRoll(double start, double end);
+        void endLoopRoll();
+
+        bool isLooping() const noexcept;
+        double getLoopStart() const noexcept;
+        double getLoopEnd() const noexcept;
+
+    private:
+        // What the audio thread reports back after every block
+        struct State
+        {
+            double position = 0.0;
+            double rate = 0.0;
+            bool playing = false;
+            bool reversed = false;
+            bool finished = false;
+            bool buffering = false;
+            bool looping = false;
+            double loopStart = 0.0;
+            double loopEnd = 0.0;
+
+            // The newest command received by the time of the snapshot, and how many tracks
+            // setTrack had been given
+            juce::uint32 lastCommand = 0;
+            juce::uint32 tracksReceived = 0;
+            juce::int64 sampleClock = 0;
+        };
+
+        void send(DeckCommand::Type type, double value = 0.0, juce::int64 sampleTime = -1, double end = 0.0);
+        const State& getState() const noexcept { return publishedState.read(); }
+        bool hasApplied(juce::uint32 command) const noexcept;
+        bool isAwaitingTrack() const noexcept { return getState().tracksReceived != tracksExpected; }
+
+        void applyCommands(double numFrames);
+        void applyCommand(const DeckCommand& command, double numFrames);
+        int findNextScheduled(juce::int64 blockEnd) const noexcept;
+        void renderSegment(const juce::AudioSourceChannelInfo& segment);
+        int followLoop(int maxSamples);
+        double wrapIntoLoop(double newPosition) const noexcept;
+        void setLoopPoints(double start, double end, double numFrames);
+        void startJumpCrossfade(double tailPosition) noexcept;
+        void renderJumpTail(int numSamples, int numOutputChannels, double startIncrement, double endIncrement);
+        void mixJumpTail(const juce::AudioSourceChannelInfo& segment);
+        void publishState();
+        double getTargetRate() const noexcept;
+        void renderUnityRate(const juce::AudioSourceChannelInfo& bufferToFill, bool backwards);
+        void renderInterpolated(const juce::AudioSourceChannelInfo& bufferToFill, double startIncrement, double endIncrement);
+        void renderStretched(const juce::AudioSourceChannelInfo& bufferToFill, double startIncrement, double endIncrement, double sampleRateRatio);
+        void fillWindow(juce::int64 firstFrame, int numWindowFrames, int numChannels);
+
+        static constexpr double spinbackRate = -3.0;
+        static constexpr double defaultRateRampSeconds = 0.05;
+
+        // Commands waiting for a later sample, and the fade that takes the click out of
+        // a start on an exact sample
+        static constexpr int maxScheduled = 32;
+        static constexpr int declickSamples = 64;
+
+        // Length of the crossfade wherever playback jumps
+        static constexpr double jumpCrossfadeSeconds = 0.003;
+
+        // Source channels the resampler can read at once. Outputs beyond this repeat them.
+        static constexpr int maxWindowChannels = 8;
+
+        // Tells a track that decks share which of them is playing where
+        static inline std::atomic<int> nextPlayheadId { 0 };
+        const int playheadId = nextPlayheadId++;
+
+        // Owned by the audio thread
+        TrackSamples* samples = nullptr;
+        MemoryAudioSource* unitySource = nullptr;
+        double sourceSampleRate = 44100.0;
+        double deviceSampleRate = 44100.0;
+        double position = 0.0;
+        double currentRate = 0.0;
+        bool braking = false;
+        double brakeRatePerSecond = 0.0;
+        double rateRampTarget = 0.0;
+        double rateRampStep = 0.0;
+        bool playing = false;
+        bool reversed = false;
+        bool finished = false;
+        bool buffering = false;
+        bool scratching = false;
+        bool keyLock = false;
+        Resampler::Quality resamplerQuality = Resampler::Quality::Sinc;
+        juce::uint32 lastReceivedCommand = 0;
+        juce::uint32 tracksReceived = 0;
+        juce::int64 sampleClock = 0;
+        std::array<DeckCommand, maxScheduled> scheduled;
+        int numScheduled = 0;
+        int declickRemaining = 0;
+
+        // The loop, and where playback would be without it while a roll is held
+        bool looping = false;
+        bool insideLoop = false;
+        double loopStart = 0.0;
+        double loopEnd = 0.0;
+        bool rolling = false;
+        double rollPosition = 0.0;
+
+        // Carries on past the edge the playhead just jumped from, fading out under the new audio
+        juce::AudioBuffer<float> jumpTail;
+        std::vector<float> jumpFadeIn, jumpFadeOut;
+        double jumpTailPosition = 0.0;
+        int jumpCrossfadeRemaining = 0;
+
+        // Float copy of the stretch of track the resampler is reading from
+        juce::AudioBuffer<float> window;
+        juce::int64 windowStart = 0;
+
+        TimeStretcher stretcher;
+        bool stretching = false;
+
+        // Actions from the control side, in order
+        DeckCommandQueue commands;
+
+        // Continuous controls, where only the latest value matters
+        std::atomic<double> speed { 1.0 };
+        std::atomic<double> nudge { 0.0 };
+        std::atomic<double> scratchRate { 0.0 };
+        std::atomic<double> rateRampSeconds { defaultRateRampSeconds };
+
+        // Whether the next track starts playing, kept up to date by every start and stop
+        std::atomic<bool> nextTrackPlaying { false };
+
+        // Owned by the message thread: what was last asked for, and by which command
+        juce::uint32 lastSentCommand = 0;
+        bool requestedPlaying = false;
+        bool requestedReversed = false;
+        bool requestedScratching = false;
+        bool requestedKeyLock = false;
+        Resampler::Quality requestedQuality = Resampler::Quality::Sinc;
+        double requestedPosition = 0.0;
+        bool requestedLooping = false;
+        double requestedLoopStart = 0.0, requestedLoopEnd = 0.0;
+        juce::uint32 playCommand = 0, reverseCommand = 0, seekCommand = 0, loopCommand = 0;
+        juce::uint32 tracksExpected = 0;
+
+        // Written by the audio thread, read by the message thread
+        mutable TripleBuffer<State> publishedState;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DeckPlayhead)
+    };
+}
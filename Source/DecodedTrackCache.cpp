@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    DecodedTrackCache.cpp
+
+  ==============================================================================
+*/
+
+#include "DecodedTrackCache.h"
+
+DecodedTrackCache::DecodedTrackCache(juce::int64 memoryBudgetBytes)
+    : memoryBudget(memoryBudgetBytes)
+{
+    decodeThread.startThread();
+}
+
+DecodedTrackCache::~DecodedTrackCache()
+{
+    // Entries still decoding unregister from the thread as they go
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+}
+
+std::shared_ptr<OtoDecksAudio::ProgressiveSamples> DecodedTrackCache::find(const juce::File& file, OtoDecksAudio::SampleStorage::Format format,
+                                                                           double targetSampleRate)
+{
+    const auto path = file.getFullPathName();
+    const auto modificationTime = file.getLastModificationTime();
+
+    const juce::ScopedLock sl(lock);
+
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->path == path && it->format == format && it->targetSampleRate == targetSampleRate)
+        {
+            // The file has changed since it was decoded, so the entry is no use to anyone
+            if (it->modificationTime != modificationTime)
+            {
+                entries.erase(it);
+                break;
+            }
+
+            entries.splice(entries.begin(), entries, it);
+            ++hits;
+            return entries.front().samples;
+        }
+    }
+
+    ++misses;
+    return nullptr;
+}
+
+void DecodedTrackCache::add(const juce::File& file, OtoDecksAudio::SampleStorage::Format format, double targetSampleRate,
+                            std::shared_ptr<OtoDecksAudio::ProgressiveSamples> samples)
+{
+    if (samples == nullptr)
+        return;
+
+    Entry entry { file.getFullPathName(), file.getLastModificationTime(), format, targetSampleRate, std::move(samples) };
+
+    const juce::ScopedLock sl(lock);
+
+    entries.remove_if([&entry](const Entry& e)
+    {
+        return e.path == entry.path && e.format == entry.format && e.targetSampleRate == entry.targetSampleRate;
+    });
+    entries.push_front(std::move(entry));
+
+    evictToFitBudget();
+}
+
+void DecodedTrackCache::setMemoryBudget(juce::int64 memoryBudgetBytes)
+{
+    const juce::ScopedLock sl(lock);
+    memoryBudget = memoryBudgetBytes;
+    evictToFitBudget();
+}
+
+juce::int64 DecodedTrackCache::getMemoryBudget() const
+{
+    const juce::ScopedLock sl(lock);
+    return memoryBudget;
+}
+
+juce::int64 DecodedTrackCache::getSizeInBytes() const
+{
+    const juce::ScopedLock sl(lock);
+    juce::int64 total = 0;
+
+    for (auto& entry : entries)
+        total += (juce::int64)entry.samples->getSizeInBytes();
+
+    return total;
+}
+
+DecodedTrackCache::Statistics DecodedTrackCache::getStatistics() const noexcept
+{
+    return { hits.load(), misses.load(), evictions.load() };
+}
+
+void DecodedTrackCache::evictToFitBudget()
+{
+    // A track still decoding counts at its full size: its storage is allocated for the
+    // whole track up front, so that is what it holds even before the rest is decoded
+    juce::int64 total = 0;
+
+    for (auto& entry : entries)
+        total += (juce::int64)entry.samples->getSizeInBytes();
+
+    // Walk from the least recently used end. Entries a deck is still playing would
+    // stay in memory anyway, so they are kept for the next time they're loaded.
+    for (auto it = entries.end(); it != entries.begin() && total > memoryBudget;)
+    {
+        --it;
+
+        if (it->samples.use_count() > 1)
+            continue;
+
+        total -= (juce::int64)it->samples->getSizeInBytes();
+        it = entries.erase(it);
+        ++evictions;
+    }
+}
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    DecodedTrackCache.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <list>
+#include "ProgressiveSamples.h"
+
+// Decoded tracks shared by every deck, so loading a track that is already on the
+// other deck, or was played recently, doesn't decode it again. Entries are keyed by
+// file, modification time, storage format and the rate they were converted to, and
+// are never changed once added; decks hold their own reference, so an entry can be
+// evicted while still playing.
+//
+// The least recently used entries that no deck is playing are evicted whenever the
+// cache grows beyond its memory budget. All methods are thread-safe.
+class DecodedTrackCache
+{
+public:
+    struct Statistics
+    {
+        juce::int64 hits = 0;
+        juce::int64 misses = 0;
+        juce::int64 evictions = 0;
+    };
+
+    explicit DecodedTrackCache(juce::int64 memoryBudgetBytes = 512 * 1024 * 1024);
+    ~DecodedTrackCache();
+
+    // Returns the cached samples for the file, or nullptr if there are none. The target
+    // rate is the one the samples were asked to be converted to, or zero for none.
+    std::shared_ptr<OtoDecksAudio::ProgressiveSamples> find(const juce::File& file, OtoDecksAudio::SampleStorage::Format format,
+                                                            double targetSampleRate);
+
+    // Adds samples that have just been decoded from the file
+    void add(const juce::File& file, OtoDecksAudio::SampleStorage::Format format, double targetSampleRate,
+             std::shared_ptr<OtoDecksAudio::ProgressiveSamples> samples);
+
+    void setMemoryBudget(juce::int64 memoryBudgetBytes);
+    juce::int64 getMemoryBudget() const;
+
+    // Memory held by every cached entry, including ones a deck is using. Tracks still
+    // decoding count in full, as their storage is allocated when they're added.
+    juce::int64 getSizeInBytes() const;
+
+    Statistics getStatistics() const noexcept;
+
+    // Finishes decoding cached tracks in the background. It lives as long as the
+    // cache, so tracks decoding on it outlive whichever deck loaded them.
+    juce::TimeSliceThread& getDecodeThread() noexcept { return decodeThread; }
+
+    // Converts the channels of decoded audio to the device rate side by side
+    juce::ThreadPool& getConversionPool() noexcept { return conversionPool; }
+
+private:
+    struct Entry
+    {
+        juce::String path;
+        juce::Time modificationTime;
+        OtoDecksAudio::SampleStorage::Format format;
+        double targetSampleRate;
+        std::shared_ptr<OtoDecksAudio::ProgressiveSamples> samples;
+    };
+
+    void evictToFitBudget();
+
+    // Declared first so they are destroyed after every entry decoding on them
+    juce::ThreadPool conversionPool { juce::jmax(1, juce::SystemStats::getNumCpus() - 1) };
+    juce::TimeSliceThread decodeThread { "Track decoding" };
+
+    juce::CriticalSection lock;
+
+    // Most recently used first
+    std::list<Entry> entries;
+    juce::int64 memoryBudget;
+
+    std::atomic<juce::int64> hits { 0 };
+    std::atomic<juce::int64> misses { 0 };
+    std::atomic<juce::int64> evictions { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecodedTrackCache)
+};
@@ -0,0 +1,220 @@
+/*
+  ==============================================================================
+
+    IsolatorEQ.cpp
+
+  ==============================================================================
+*/
+
+#include "IsolatorEQ.h"
+#include "SimdHelpers.h"
+
+namespace OtoDecksAudio
+{
+    namespace
+    {
+        using namespace Simd;
+
+        // One biquad's coefficients and state, held in registers across a run of samples
+        struct QuadStage
+        {
+            Quad b0, b1, b2, a1, a2, s1, s2;
+
+            inline Quad process(Quad x) noexcept
+            {
+                const Quad y = add(mul(b0, x), s1);
+                s1 = add(sub(mul(b1, x), mul(a1, y)), s2);
+                s2 = sub(mul(b2, x), mul(a2, y));
+                return y;
+            }
+        };
+    }
+
+    //==============================================================================
+    IsolatorEQ::IsolatorEQ()
+    {
+        for (auto& gain : gains)
+            gain = 1.0f;
+
+        for (auto& kill : kills)
+            kill = false;
+
+        prepare(44100.0);
+    }
+
+    void IsolatorEQ::setBandGain(Band band, float gain) noexcept
+    {
+        gains[(size_t)band] = juce::jlimit(0.0f, maxBandGain, gain);
+    }
+
+    void IsolatorEQ::setBandKill(Band band, bool shouldKill) noexcept
+    {
+        kills[(size_t)band] = shouldKill;
+    }
+
+    void IsolatorEQ::prepare(double sampleRate)
+    {
+        const auto lowPass = makeLowPass(sampleRate, lowCrossoverHz);
+        const auto highPass = makeHighPass(sampleRate, lowCrossoverHz);
+        const auto upperLowPass = makeLowPass(sampleRate, highCrossoverHz);
+        const auto upperHighPass = makeHighPass(sampleRate, highCrossoverHz);
+        const auto allPass = makeAllPass(sampleRate, highCrossoverHz);
+
+        setStage(stages[lowSplit1], lowPass, highPass);
+        setStage(stages[lowSplit2], lowPass, highPass);
+        setStage(stages[highSplit1], upperLowPass, upperHighPass);
+        setStage(stages[highSplit2], upperLowPass, upperHighPass);
+        setStage(stages[lowAllPass], allPass, allPass);
+
+        for (size_t band = 0; band < bandGains.size(); ++band)
+        {
+            bandGains[band].prepare(sampleRate, gainRampSeconds);
+            bandGains[band].setCurrentAndTarget(kills[band].load() ? 0.0f : gains[band].load());
+        }
+
+        reset();
+    }
+
+    void IsolatorEQ::reset() noexcept
+    {
+        for (auto& stage : stages)
+        {
+            std::fill(std::begin(stage.s1), std::end(stage.s1), 0.0f);
+            std::fill(std::begin(stage.s2), std::end(stage.s2), 0.0f);
+        }
+    }
+
+    //==============================================================================
+    IsolatorEQ::Coefficients IsolatorEQ::makeLowPass(double sampleRate, double frequency) noexcept
+    {
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosW = std::cos(w);
+        const double alpha = std::sin(w) / juce::MathConstants<double>::sqrt2;
+        const double a0 = 1.0 + alpha;
+
+        return { (float)((1.0 - cosW) * 0.5 / a0), (float)((1.0 - cosW) / a0), (float)((1.0 - cosW) * 0.5 / a0),
+                 (float)(-2.0 * cosW / a0), (float)((1.0 - alpha) / a0) };
+    }
+
+    IsolatorEQ::Coefficients IsolatorEQ::makeHighPass(double sampleRate, double frequency) noexcept
+    {
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosW = std::cos(w);
+        const double alpha = std::sin(w) / juce::MathConstants<double>::sqrt2;
+        const double a0 = 1.0 + alpha;
+
+        return { (float)((1.0 + cosW) * 0.5 / a0), (float)(-(1.0 + cosW) / a0), (float)((1.0 + cosW) * 0.5 / a0),
+                 (float)(-2.0 * cosW / a0), (float)((1.0 - alpha) / a0) };
+    }
+
+    IsolatorEQ::Coefficients IsolatorEQ::makeAllPass(double sampleRate, double frequency) noexcept
+    {
+        // What a Linkwitz-Riley low and high pass add up to at the same frequency
+        const double w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const double cosW = std::cos(w);
+        const double alpha = std::sin(w) / juce::MathConstants<double>::sqrt2;
+        const double a0 = 1.0 + alpha;
+
+        return { (float)((1.0 - alpha) / a0), (float)(-2.0 * cosW / a0), 1.0f,
+                 (float)(-2.0 * cosW / a0), (float)((1.0 - alpha) / a0) };
+    }
+
+    void IsolatorEQ::setStage(Stage& stage, const Coefficients& left, const Coefficients& right) noexcept
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const auto& c = lane < 2 ? left : right;
+            stage.b0[lane] = c.b0;
+            stage.b1[lane] = c.b1;
+            stage.b2[lane] = c.b2;
+            stage.a1[lane] = c.a1;
+            stage.a2[lane] = c.a2;
+        }
+    }
+
+    //==============================================================================
+    void IsolatorEQ::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+    {
+        if (buffer.getNumChannels() == 0 || numSamples <= 0)
+            return;
+
+        for (size_t band = 0; band < bandGains.size(); ++band)
+            bandGains[band].setTarget(kills[band].load(std::memory_order_relaxed) ? 0.0f : gains[band].load(std::memory_order_relaxed));
+
+        float* left = buffer.getWritePointer(0, startSample);
+        float* right = buffer.getNumChannels() > 1 ? buffer.getWritePointer(1, startSample) : nullptr;
+
+        // Each band glides in a straight line until its ramp ends, so run up to the next
+        // end with all three steady
+        for (int offset = 0; offset < numSamples;)
+        {
+            int num = numSamples - offset;
+
+            for (const auto& gain : bandGains)
+                if (gain.isRamping())
+                    num = juce::jmin(num, gain.getRemainingSteps());
+
+            processSegment(left + offset, right != nullptr ? right + offset : nullptr, num);
+
+            for (auto& gain : bandGains)
+                gain.skip(num);
+
+            offset += num;
+        }
+    }
+
+    void IsolatorEQ::processSegment(float* left, float* right, int numSamples) noexcept
+    {
+        QuadStage quads[numStages];
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            const auto& stage = stages[(size_t)i];
+            quads[i] = { loadQuad(stage.b0), loadQuad(stage.b1), loadQuad(stage.b2), loadQuad(stage.a1), loadQuad(stage.a2),
+                         loadQuad(stage.s1), loadQuad(stage.s2) };
+        }
+
+        const auto& low = bandGains[(size_t)Band::low];
+        const auto& mid = bandGains[(size_t)Band::mid];
+        const auto& high = bandGains[(size_t)Band::high];
+
+        // The allpassed low band sits in the first two lanes, mid and high in the four of
+        // the upper split, so the spare lanes get a gain of zero
+        const Quad lowStart = makeQuad(low.getCurrent(), low.getCurrent(), 0.0f, 0.0f);
+        const Quad lowStep = makeQuad(low.getStep(), low.getStep(), 0.0f, 0.0f);
+        const Quad upperStart = makeQuad(mid.getCurrent(), mid.getCurrent(), high.getCurrent(), high.getCurrent());
+        const Quad upperStep = makeQuad(mid.getStep(), mid.getStep(), high.getStep(), high.getStep());
+
+        alignas(16) float out[4];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float inLeft = left[i];
+            const float inRight = right != nullptr ? right[i] : inLeft;
+
+            // { low left, low right, rest left, rest right }
+            const Quad split = quads[lowSplit2].process(quads[lowSplit1].process(makeQuad(inLeft, inRight, inLeft, inRight)));
+
+            // { mid left, mid right, high left, high right }
+            const Quad upper = quads[highSplit2].process(quads[highSplit1].process(upperPair(split)));
+            const Quad lowBand = quads[lowAllPass].process(split);
+
+            const Quad index = makeQuad((float)(i + 1), (float)(i + 1), (float)(i + 1), (float)(i + 1));
+            const Quad mixed = add(mul(upper, add(upperStart, mul(upperStep, index))),
+                                   mul(lowBand, add(lowStart, mul(lowStep, index))));
+
+            storeQuad(out, add(mixed, swapPairs(mixed)));
+            left[i] = out[0];
+
+            if (right != nullptr)
+                right[i] = out[1];
+        }
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            auto& stage = stages[(size_t)i];
+            storeQuad(stage.s1, quads[i].s1);
+            storeQuad(stage.s2, quads[i].s2);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    IsolatorEQ.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "ParameterRamp.h"
+
+namespace OtoDecksAudio
+{
+    // A DJ-style three band isolator. The signal is split into low, mid and high bands by
+    // fourth-order Linkwitz-Riley crossovers, each made of two Butterworth biquads, and
+    // the bands are summed back with a gain each. The low band also goes through the
+    // allpass the upper split adds to the others, so with every gain at one the bands sum
+    // back flat, and a band at zero is gone entirely.
+    //
+    // The biquads run four at a time in vector lanes: both sides of a split for both
+    // stereo channels. Their coefficients only depend on the sample rate, so they're
+    // worked out in prepare, and the band gains glide to new settings inside the same
+    // loop that sums the bands. It always runs, so the filters never restart from stale
+    // state when a knob moves.
+    class IsolatorEQ
+    {
+    public:
+        enum class Band { low, mid, high };
+
+        static constexpr int numBands = 3;
+        static constexpr double lowCrossoverHz = 250.0;
+        static constexpr double highCrossoverHz = 2500.0;
+
+        // Band gains run from silent to about +6 dB
+        static constexpr float maxBandGain = 2.0f;
+
+        IsolatorEQ();
+
+        // Any thread. Kills silence a band whatever its gain is.
+        void setBandGain(Band band, float gain) noexcept;
+        void setBandKill(Band band, bool shouldKill) noexcept;
+        float getBandGain(Band band) const noexcept { return gains[(size_t)band].load(); }
+        bool isBandKilled(Band band) const noexcept { return kills[(size_t)band].load(); }
+
+        void prepare(double sampleRate);
+        void reset() noexcept;
+
+        // Audio thread. Filters the first two channels in place; a mono buffer is filtered as one.
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+    private:
+        // Four lanes of one biquad, transposed direct form II
+        struct alignas(16) Stage
+        {
+            float b0[4], b1[4], b2[4], a1[4], a2[4];
+            float s1[4], s2[4];
+        };
+
+        struct Coefficients
+        {
+            float b0, b1, b2, a1, a2;
+        };
+
+        static Coefficients makeLowPass(double sampleRate, double frequency) noexcept;
+        static Coefficients makeHighPass(double sampleRate, double frequency) noexcept;
+        static Coefficients makeAllPass(double sampleRate, double frequency) noexcept;
+
+        // Lanes 0 and 1 take the first coefficients, lanes 2 and 3 the second
+        static void setStage(Stage& stage, const Coefficients& left, const Coefficients& right) noexcept;
+
+        void processSegment(float* left, float* right, int numSamples) noexcept;
+
+        static constexpr double gainRampSeconds = 0.01;
+
+        // Stages in signal order: the lower split twice, the upper split twice on what
+        // the lower one passed up, and the matching allpass on the low band
+        enum { lowSplit1, lowSplit2, highSplit1, highSplit2, lowAllPass, numStages };
+        std::array<Stage, numStages> stages {};
+
+        std::array<std::atomic<float>, numBands> gains;
+        std::array<std::atomic<bool>, numBands> kills;
+
+        // Owned by the audio thread
+        std::array<ParameterRamp, numBands> bandGains;
+    };
+}
@@ -0,0 +1,330 @@
+/*
+  ==============================================================================
+
+    LevelMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+#include "SimdHelpers.h"
+
+namespace OtoDecksAudio
+{
+    using namespace Simd;
+
+    //==============================================================================
+    LevelMeter::LevelMeter()
+    {
+        // Windowed sinc at the input's Nyquist, one tap in four landing on each phase
+        constexpr int numTaps = oversampling * tapsPerPhase;
+        constexpr double centre = (numTaps - 1) * 0.5;
+
+        for (int phase = 0; phase < oversampling; ++phase)
+        {
+            double phaseSum = 0.0;
+
+            for (int tap = 0; tap < tapsPerPhase; ++tap)
+            {
+                const int i = tap * oversampling + phase;
+                const double x = (i - centre) / oversampling;
+                const double sinc = std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                const double window = 0.42 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * i / (numTaps - 1))
+                                      + 0.08 * std::cos(2.0 * juce::MathConstants<double>::twoPi * i / (numTaps - 1));
+
+                phaseTaps[tap][phase] = (float)(sinc * window);
+                phaseSum += sinc * window;
+            }
+
+            // Every phase passes DC unchanged
+            for (int tap = 0; tap < tapsPerPhase; ++tap)
+                phaseTaps[tap][phase] = (float)(phaseTaps[tap][phase] / phaseSum);
+        }
+
+        for (auto& history : truePeakHistory)
+            history.resize((size_t)(truePeakChunk + tapsPerPhase - 1));
+    }
+
+    void LevelMeter::prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        peakHoldSamples = (int)(peakHoldSeconds * sampleRate);
+        loudnessStepSamples = juce::jmax(1, (int)(loudnessStepSeconds * sampleRate));
+
+        // Lanes 0 and 1 take the first coefficients, lanes 2 and 3 the second
+        const Coefficients stages[] = { makeHighShelf(sampleRate), makeHighPass(sampleRate) };
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const auto& c = stages[lane / 2];
+            kWeighting.b0[lane] = c.b0;
+            kWeighting.b1[lane] = c.b1;
+            kWeighting.b2[lane] = c.b2;
+            kWeighting.a1[lane] = c.a1;
+            kWeighting.a2[lane] = c.a2;
+        }
+
+        reset();
+    }
+
+    void LevelMeter::reset() noexcept
+    {
+        state = {};
+        holdRemaining = {};
+        meanSquare = {};
+
+        for (auto& history : truePeakHistory)
+            std::fill(history.begin(), history.end(), 0.0f);
+
+        std::fill(std::begin(kWeighting.s1), std::end(kWeighting.s1), 0.0f);
+        std::fill(std::begin(kWeighting.s2), std::end(kWeighting.s2), 0.0f);
+        kWeighting.pending[0] = kWeighting.pending[1] = 0.0f;
+
+        loudnessStepRemaining = loudnessStepSamples;
+        loudnessStepSum = 0.0;
+        loudnessSteps = {};
+        loudnessStepIndex = 0;
+
+        published.write(state);
+    }
+
+    // The BS.1770 pre-filter and RLB high pass, worked out for any sample rate rather
+    // than taken from the 48 kHz tables
+    LevelMeter::Coefficients LevelMeter::makeHighShelf(double sampleRate) noexcept
+    {
+        const double k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        const double q = 0.7071752369554196;
+        const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        return { (float)((vh + vb * k / q + k * k) / a0),
+                 (float)(2.0 * (k * k - vh) / a0),
+                 (float)((vh - vb * k / q + k * k) / a0),
+                 (float)(2.0 * (k * k - 1.0) / a0),
+                 (float)((1.0 - k / q + k * k) / a0) };
+    }
+
+    LevelMeter::Coefficients LevelMeter::makeHighPass(double sampleRate) noexcept
+    {
+        const double k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        const double q = 0.5003270373238773;
+        const double a0 = 1.0 + k / q + k * k;
+
+        return { 1.0f, -2.0f, 1.0f,
+                 (float)(2.0 * (k * k - 1.0) / a0),
+                 (float)((1.0 - k / q + k * k) / a0) };
+    }
+
+    float LevelMeter::toLoudness(double meanSquare) noexcept
+    {
+        if (meanSquare <= 0.0)
+            return minLoudness;
+
+        return juce::jmax(minLoudness, (float)(-0.691 + 10.0 * std::log10(meanSquare)));
+    }
+
+    //==============================================================================
+    void LevelMeter::process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, float gain) noexcept
+    {
+        if (resetPending.exchange(false, std::memory_order_acq_rel))
+            reset();
+
+        if (maximumResetPending.exchange(false, std::memory_order_acq_rel))
+            state.maxTruePeak = 0.0f;
+
+        const int numInputs = juce::jmin(buffer.getNumChannels(), numChannels);
+
+        if (numInputs == 0 || numSamples <= 0)
+            return;
+
+        const float* channels[numChannels];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = buffer.getReadPointer(juce::jmin(channel, numInputs - 1), startSample);
+
+        const float fall = (float)std::pow(10.0, -peakFallDecibelsPerSecond * numSamples / (20.0 * sampleRate));
+        const double rmsKeep = std::exp(-numSamples / (rmsSeconds * sampleRate));
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            // A mono buffer measures the same on both sides
+            if (channel >= numInputs)
+            {
+                state.peak[(size_t)channel] = state.peak[0];
+                state.peakHold[(size_t)channel] = state.peakHold[0];
+                state.rms[(size_t)channel] = state.rms[0];
+                state.truePeak[(size_t)channel] = state.truePeak[0];
+                continue;
+            }
+
+            float blockPeak = 0.0f, sumOfSquares = 0.0f;
+            measure(channels[channel], numSamples, blockPeak, sumOfSquares);
+            blockPeak *= gain;
+
+            const float blockTruePeak = measureTruePeak(channel, channels[channel], numSamples) * gain;
+
+            auto& peak = state.peak[(size_t)channel];
+            auto& hold = state.peakHold[(size_t)channel];
+            auto& truePeak = state.truePeak[(size_t)channel];
+
+            peak = juce::jmax(blockPeak, peak * fall);
+            truePeak = juce::jmax(blockTruePeak, truePeak * fall);
+            state.maxTruePeak = juce::jmax(state.maxTruePeak, blockTruePeak);
+
+            if (blockPeak >= hold)
+            {
+                hold = blockPeak;
+                holdRemaining[(size_t)channel] = peakHoldSamples;
+            }
+            else if ((holdRemaining[(size_t)channel] -= numSamples) <= 0)
+            {
+                hold = peak;
+            }
+
+            auto& ms = meanSquare[(size_t)channel];
+            ms = ms * rmsKeep + (1.0 - rmsKeep) * (double)sumOfSquares * gain * gain / numSamples;
+            state.rms[(size_t)channel] = (float)std::sqrt(ms);
+        }
+
+        // Loudness is summed up to each 100 ms step, with the gain applied to the energy
+        for (int offset = 0; offset < numSamples;)
+        {
+            const int num = juce::jmin(numSamples - offset, loudnessStepRemaining);
+
+            double leftSum = 0.0, rightSum = 0.0;
+            weighLoudness(channels[0] + offset, channels[1] + offset, num, leftSum, rightSum);
+
+            // The channels are summed as BS.1770 has it, so mono counts once
+            loudnessStepSum += (numInputs > 1 ? leftSum + rightSum : leftSum) * gain * gain;
+
+            offset += num;
+
+            if ((loudnessStepRemaining -= num) == 0)
+                endLoudnessStep();
+        }
+
+        published.write(state);
+    }
+
+    void LevelMeter::endLoudnessStep() noexcept
+    {
+        loudnessSteps[(size_t)loudnessStepIndex] = loudnessStepSum / loudnessStepSamples;
+        loudnessStepIndex = (loudnessStepIndex + 1) % shortTermSteps;
+        loudnessStepSum = 0.0;
+        loudnessStepRemaining = loudnessStepSamples;
+
+        double momentary = 0.0, shortTerm = 0.0;
+
+        for (int i = 0; i < shortTermSteps; ++i)
+        {
+            // Counting back from the step just finished
+            const double step = loudnessSteps[(size_t)((loudnessStepIndex - 1 - i + shortTermSteps) % shortTermSteps)];
+
+            if (i < momentarySteps)
+                momentary += step;
+
+            shortTerm += step;
+        }
+
+        state.momentaryLoudness = toLoudness(momentary / momentarySteps);
+        state.shortTermLoudness = toLoudness(shortTerm / shortTermSteps);
+    }
+
+    //==============================================================================
+    void LevelMeter::measure(const float* samples, int numSamples, float& peak, float& sumOfSquares) noexcept
+    {
+        Quad highest = splat(0.0f), squares = splat(0.0f);
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const Quad x = loadUnaligned(samples + i);
+            highest = max(highest, abs(x));
+            squares = add(squares, mul(x, x));
+        }
+
+        peak = highestLane(highest);
+        sumOfSquares = sumOfLanes(squares);
+
+        for (; i < numSamples; ++i)
+        {
+            peak = juce::jmax(peak, std::abs(samples[i]));
+            sumOfSquares += samples[i] * samples[i];
+        }
+    }
+
+    float LevelMeter::measureTruePeak(int channel, const float* samples, int numSamples) noexcept
+    {
+        constexpr int historyLength = tapsPerPhase - 1;
+        float* history = truePeakHistory[(size_t)channel].data();
+
+        Quad taps[tapsPerPhase];
+
+        for (int tap = 0; tap < tapsPerPhase; ++tap)
+            taps[tap] = loadQuad(phaseTaps[tap]);
+
+        Quad highest = splat(0.0f);
+
+        for (int offset = 0; offset < numSamples;)
+        {
+            const int num = juce::jmin(truePeakChunk, numSamples - offset);
+
+            // The last few samples of the previous chunk stay in front for the filter to reach back to
+            std::memcpy(history + historyLength, samples + offset, sizeof(float) * (size_t)num);
+
+            // Every input sample gives all four phases at once, one lane each
+            for (int n = 0; n < num; ++n)
+            {
+                const float* newest = history + historyLength + n;
+                Quad sum = mul(taps[0], splat(newest[0]));
+
+                for (int tap = 1; tap < tapsPerPhase; ++tap)
+                    sum = add(sum, mul(taps[tap], splat(newest[-tap])));
+
+                highest = max(highest, abs(sum));
+            }
+
+            std::memmove(history, history + num, sizeof(float) * historyLength);
+            offset += num;
+        }
+
+        return highestLane(highest);
+    }
+
+    void LevelMeter::weighLoudness(const float* left, const float* right, int numSamples,
+                                   double& leftSum, double& rightSum) noexcept
+    {
+        const Quad b0 = loadQuad(kWeighting.b0), b1 = loadQuad(kWeighting.b1), b2 = loadQuad(kWeighting.b2);
+        const Quad a1 = loadQuad(kWeighting.a1), a2 = loadQuad(kWeighting.a2);
+        Quad s1 = loadQuad(kWeighting.s1), s2 = loadQuad(kWeighting.s2);
+
+        // Lanes 2 and 3 start on what the first stage left for them last time
+        Quad y = pairWithLow(kWeighting.pending[0], kWeighting.pending[1], splat(0.0f));
+        Quad squares = splat(0.0f);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const Quad x = pairWithLow(left[i], right[i], y);
+
+            y = add(mul(b0, x), s1);
+            s1 = add(sub(mul(b1, x), mul(a1, y)), s2);
+            s2 = sub(mul(b2, x), mul(a2, y));
+
+            squares = add(squares, mul(y, y));
+        }
+
+        storeQuad(kWeighting.s1, s1);
+        storeQuad(kWeighting.s2, s2);
+
+        alignas(16) float lanes[4];
+        storeQuad(lanes, y);
+        kWeighting.pending[0] = lanes[0];
+        kWeighting.pending[1] = lanes[1];
+
+        // Only the second stage's lanes are the weighted signal
+        storeQuad(lanes, squares);
+        leftSum = lanes[2];
+        rightSum = lanes[3];
+    }
+}
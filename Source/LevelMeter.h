@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+namespace OtoDecksAudio
+{
+    // Measures a stereo signal on the audio thread and hands the results to the GUI.
+    //
+    // Sample peak and RMS come out of one vectorized pass over each channel. True peak is
+    // the highest of the signal upsampled four times by a polyphase interpolator, the four
+    // phases of each input sample worked out together in vector lanes. Loudness follows
+    // ITU-R BS.1770: both channels through the K-weighting filters, four lanes at a time
+    // with the second stage one sample behind the first, and summed in 100 ms steps into
+    // the momentary (400 ms) and short-term (3 s) windows.
+    //
+    // Each block's results go out through a triple buffer, so neither side ever waits.
+    // Peaks fall back slowly rather than being reset per block, so the GUI sees them even
+    // when it skips blocks.
+    class LevelMeter
+    {
+    public:
+        static constexpr int numChannels = 2;
+
+        // What the meter shows below this is silence
+        static constexpr float minLoudness = -70.0f;
+
+        // Gains, apart from the loudness figures in LUFS
+        struct Reading
+        {
+            std::array<float, numChannels> peak {};
+            std::array<float, numChannels> peakHold {};
+            std::array<float, numChannels> rms {};
+            std::array<float, numChannels> truePeak {};
+
+            // The highest true peak since resetMaximum, to catch clipping that came and went
+            float maxTruePeak = 0.0f;
+
+            float momentaryLoudness = minLoudness;
+            float shortTermLoudness = minLoudness;
+        };
+
+        LevelMeter();
+
+        // Not while process might be running; prepare from prepareToPlay
+        void prepare(double sampleRate);
+        void reset() noexcept;
+
+        // Any thread. The audio thread resets the meter at the start of the next block.
+        void resetOnNextBlock() noexcept { resetPending = true; }
+
+        // Audio thread. Measures the first two channels, scaled by gain; a mono buffer is
+        // measured as one channel shown on both sides.
+        void process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, float gain = 1.0f) noexcept;
+
+        // One thread at a time, usually the meter's component
+        const Reading& getReading() noexcept { return published.read(); }
+
+        // Any thread. Applied at the start of the next block.
+        void resetMaximum() noexcept { maximumResetPending = true; }
+
+        static constexpr double peakHoldSeconds = 2.0;
+        static constexpr double peakFallDecibelsPerSecond = 12.0;
+        static constexpr double rmsSeconds = 0.3;
+
+    private:
+        // The interpolator: four phases of twelve taps, each phase's taps in vector lanes
+        static constexpr int oversampling = 4;
+        static constexpr int tapsPerPhase = 12;
+        static constexpr int truePeakChunk = 256;
+
+        // Loudness is summed over blocks of this long, and each window is a run of them
+        static constexpr double loudnessStepSeconds = 0.1;
+        static constexpr int momentarySteps = 4;
+        static constexpr int shortTermSteps = 30;
+
+        struct Coefficients
+        {
+            float b0, b1, b2, a1, a2;
+        };
+
+        // Lanes 0 and 1 run the first stage for each channel, lanes 2 and 3 the second
+        struct alignas(16) KWeighting
+        {
+            float b0[4], b1[4], b2[4], a1[4], a2[4];
+            float s1[4], s2[4];
+
+            // What the first stage put out last, waiting for the second stage
+            float pending[2];
+        };
+
+        static Coefficients makeHighShelf(double sampleRate) noexcept;
+        static Coefficients makeHighPass(double sampleRate) noexcept;
+
+        // One vectorized pass for the sample peak and the sum of squares
+        static void measure(const float* samples, int numSamples, float& peak, float& sumOfSquares) noexcept;
+
+        float measureTruePeak(int channel, const float* samples, int numSamples) noexcept;
+
+        // The K-weighted sum of squares for each channel
+        void weighLoudness(const float* left, const float* right, int numSamples, double& leftSum, double& rightSum) noexcept;
+        void endLoudnessStep() noexcept;
+
+        static float toLoudness(double meanSquare) noexcept;
+
+        double sampleRate = 44100.0;
+        int peakHoldSamples = 0;
+
+        alignas(16) float phaseTaps[tapsPerPhase][oversampling] {};
+
+        // Audio thread only
+        Reading state;
+        std::array<int, numChannels> holdRemaining {};
+        std::array<double, numChannels> meanSquare {};
+        std::array<std::vector<float>, numChannels> truePeakHistory;
+
+        KWeighting kWeighting {};
+        int loudnessStepSamples = 0;
+        int loudnessStepRemaining = 0;
+        double loudnessStepSum = 0.0;
+        std::array<double, shortTermSteps> loudnessSteps {};
+        int loudnessStepIndex = 0;
+
+        std::atomic<bool> maximumResetPending { false };
+        std::atomic<bool> resetPending { false };
+        TripleBuffer<Reading> published;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeter)
+    };
+}
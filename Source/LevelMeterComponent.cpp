@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    LevelMeterComponent.cpp
+
+  ==============================================================================
+*/
+
+#include "LevelMeterComponent.h"
+
+namespace
+{
+    int toTenths(float value) noexcept
+    {
+        return juce::roundToInt(value * 10.0f);
+    }
+
+    juce::String fromTenths(int tenths)
+    {
+        return juce::String(tenths / 10.0f, 1);
+    }
+}
+
+LevelMeterComponent::LevelMeterComponent(OtoDecksAudio::LevelMeter& meterToShow, const juce::String& titleToShow)
+    : meter(meterToShow),
+      title(titleToShow)
+{
+    // Nothing behind it needs repainting with it
+    setOpaque(true);
+}
+
+void LevelMeterComponent::resized()
+{
+    auto area = getLocalBounds().reduced(2);
+
+    titleArea = area.removeFromTop(14);
+    clipArea = area.removeFromTop(6).reduced(2, 0);
+    textArea = area.removeFromBottom(36);
+    barsArea = area.reduced(2, 2);
+}
+
+void LevelMeterComponent::enablementChanged()
+{
+    repaint();
+}
+
+int LevelMeterComponent::toHeight(float gain) const noexcept
+{
+    const float decibels = juce::Decibels::gainToDecibels(gain, minDecibels);
+    const float proportion = (decibels - minDecibels) / (maxDecibels - minDecibels);
+
+    return juce::jlimit(0, barsArea.getHeight(), juce::roundToInt(proportion * (float)barsArea.getHeight()));
+}
+
+void LevelMeterComponent::refresh()
+{
+    const auto& reading = meter.getReading();
+
+    Shown next;
+
+    for (size_t channel = 0; channel < next.peak.size(); ++channel)
+    {
+        next.peak[channel] = toHeight(reading.peak[channel]);
+        next.hold[channel] = toHeight(reading.peakHold[channel]);
+        next.rms[channel] = toHeight(reading.rms[channel]);
+    }
+
+    next.momentary = toTenths(reading.momentaryLoudness);
+    next.shortTerm = toTenths(reading.shortTermLoudness);
+    next.maxTruePeak = toTenths(juce::Decibels::gainToDecibels(reading.maxTruePeak, minDecibels));
+    next.clipped = reading.maxTruePeak > 1.0f;
+
+    if (next != shown)
+    {
+        shown = next;
+        repaint();
+    }
+}
+
+void LevelMeterComponent::mouseDown(const juce::MouseEvent&)
+{
+    meter.resetMaximum();
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(0xff1c1c1e));
+
+    const float alpha = isEnabled() ? 1.0f : 0.4f;
+
+    g.setColour(juce::Colours::white.withAlpha(alpha));
+    g.setFont(11.0f);
+    g.drawText(title, titleArea, juce::Justification::centred, false);
+
+    g.setColour((shown.clipped ? juce::Colours::red : juce::Colour(0xff3a3a3c)).withAlpha(alpha));
+    g.fillRect(clipArea);
+
+    // Full scale, for reading the bars against
+    const int zeroHeight = toHeight(1.0f);
+
+    const int numChannels = (int)shown.peak.size();
+    const int barWidth = (barsArea.getWidth() - (numChannels - 1) * 2) / numChannels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto bar = barsArea.withWidth(barWidth).translated(channel * (barWidth + 2), 0);
+        const int bottom = bar.getBottom();
+
+        g.setColour(juce::Colour(0xff2c2c2e));
+        g.fillRect(bar);
+
+        g.setColour(juce::Colour(0xff30d158).withAlpha(0.45f * alpha));
+        g.fillRect(bar.getX(), bottom - shown.peak[(size_t)channel], bar.getWidth(), shown.peak[(size_t)channel]);
+
+        g.setColour(juce::Colour(0xff30d158).withAlpha(alpha));
+        g.fillRect(bar.getX(), bottom - shown.rms[(size_t)channel], bar.getWidth(), shown.rms[(size_t)channel]);
+
+        // Anything over full scale shows in red
+        if (shown.peak[(size_t)channel] > zeroHeight)
+        {
+            g.setColour(juce::Colour(0xffff2d55).withAlpha(alpha));
+            g.fillRect(bar.getX(), bottom - shown.peak[(size_t)channel], bar.getWidth(), shown.peak[(size_t)channel] - zeroHeight);
+        }
+
+        g.setColour(juce::Colours::white.withAlpha(alpha));
+        g.fillRect(bar.getX(), bottom - shown.hold[(size_t)channel], bar.getWidth(), 1);
+    }
+
+    g.setColour(juce::Colours::grey);
+    g.fillRect(barsArea.getX(), barsArea.getBottom() - zeroHeight, barsArea.getWidth(), 1);
+
+    auto text = textArea;
+    g.setColour(juce::Colours::white.withAlpha(alpha));
+    g.setFont(10.0f);
+    g.drawText("M " + fromTenths(shown.momentary), text.removeFromTop(12), juce::Justification::centredLeft, false);
+    g.drawText("S " + fromTenths(shown.shortTerm), text.removeFromTop(12), juce::Justification::centredLeft, false);
+    g.drawText("TP " + fromTenths(shown.maxTruePeak), text.removeFromTop(12), juce::Justification::centredLeft, false);
+}
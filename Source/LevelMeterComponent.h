@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    LevelMeterComponent.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "LevelMeter.h"
+
+// Shows a LevelMeter: a bar per channel with RMS inside the peak and a line at the held
+// peak, a clip light for true peaks over full scale, and the momentary and short-term
+// loudness. It checks the meter on every display refresh but only repaints when
+// something would look different, and paints with plain rectangles. Click to clear the
+// clip light.
+class LevelMeterComponent : public juce::Component
+{
+public:
+    LevelMeterComponent(OtoDecksAudio::LevelMeter& meterToShow, const juce::String& title);
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown(const juce::MouseEvent& event) override;
+
+    // Dimmed while disabled, as the recorder's meter is when nothing is being recorded
+    void enablementChanged() override;
+
+    // The bars run from here to maxDecibels
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float maxDecibels = 6.0f;
+
+private:
+    // Everything paint draws, in pixels and tenths of a unit, so changes that wouldn't
+    // show can be told apart from ones that would
+    struct Shown
+    {
+        std::array<int, OtoDecksAudio::LevelMeter::numChannels> peak {}, hold {}, rms {};
+        int momentary = 0, shortTerm = 0, maxTruePeak = 0;
+        bool clipped = false;
+
+        bool operator==(const Shown& other) const noexcept
+        {
+            return peak == other.peak && hold == other.hold && rms == other.rms && momentary == other.momentary
+                   && shortTerm == other.shortTerm && maxTruePeak == other.maxTruePeak && clipped == other.clipped;
+        }
+
+        bool operator!=(const Shown& other) const noexcept { return !operator==(other); }
+    };
+
+    void refresh();
+
+    // Height of a gain on a bar, from the bottom
+    int toHeight(float gain) const noexcept;
+
+    OtoDecksAudio::LevelMeter& meter;
+    juce::String title;
+
+    juce::Rectangle<int> titleArea, clipArea, barsArea, textArea;
+    Shown shown;
+
+    juce::VBlankAttachment vBlank { this, [this] { refresh(); } };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LevelMeterComponent)
+};
@@ -9,6 +9,7 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "PluginScanner.h"
 
 class OtoDecksApplication  : public juce::JUCEApplication
 {
@@ -23,6 +24,12 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // A copy started to scan plugins has no window, and quits when the app that started it does
+        scanWorker = OtoDecksAudio::PluginScanWorker::createIfRequested (commandLine);
+
+        if (scanWorker != nullptr)
+            return;
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
@@ -31,6 +38,7 @@ public:
         // Add your application's shutdown code here..
 
         mainWindow = nullptr; // (deletes our window)
+        scanWorker = nullptr;
     }
 
     void systemRequestedQuit() override
@@ -80,6 +88,7 @@ public:
 
 private:
     std::unique_ptr<MainWindow> mainWindow;
+    std::unique_ptr<OtoDecksAudio::PluginScanWorker> scanWorker;
 };
 
 // This macro generates the main() routine that launches the app.
@@ -11,15 +11,151 @@ MainComponent::MainComponent()
         && ! juce::RuntimePermissions::isGranted (juce::RuntimePermissions::recordAudio))
     {
         juce::RuntimePermissions::request (juce::RuntimePermissions::recordAudio,
-                                           [&] (bool granted) { setAudioChannels (granted ? 2 : 0, 2); });
+                                           [&] (bool granted) { setAudioChannels (granted ? 2 : 0, 4); });
     }
     else
     {
-        setAudioChannels (0, 2);
+        // Outputs 3/4 carry the headphone cue where the device has them
+        setAudioChannels (0, 4);
     }
 
+    mixer.addVoice(&effects1);
+    mixer.addVoice(&effects2);
+    mixer.setCrossfaderSide(&effects1, OtoDecksAudio::DeckMixer::CrossfaderSide::left);
+    mixer.setCrossfaderSide(&effects2, OtoDecksAudio::DeckMixer::CrossfaderSide::right);
+    mixer.setVoiceMeter(&effects1, &deckMeter1);
+    mixer.setVoiceMeter(&effects2, &deckMeter2);
+
+    addAndMakeVisible(deckMeterDisplay1);
+    addAndMakeVisible(deckMeterDisplay2);
+    addAndMakeVisible(masterMeterDisplay);
+    addAndMakeVisible(recorderMeterDisplay);
+    recorderMeterDisplay.setEnabled(false);
+
+    // Trims are in decibels and double-click back to 0 dB; faders start fully up, as the mixer does
+    for (auto* trim : { &trimSlider1, &trimSlider2 })
+    {
+        addAndMakeVisible(trim);
+        trim->setSliderStyle(juce::Slider::SliderStyle::Rotary);
+        trim->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+        trim->setRange(OtoDecksAudio::DeckMixer::minTrimDecibels, OtoDecksAudio::DeckMixer::maxTrimDecibels, 0.1);
+        trim->setValue(0.0, juce::dontSendNotification);
+        trim->setDoubleClickReturnValue(true, 0.0);
+        trim->setTextValueSuffix(" dB");
+        trim->setPopupDisplayEnabled(true, false, this);
+    }
+
+    for (auto* fader : { &channelFader1, &channelFader2 })
+    {
+        addAndMakeVisible(fader);
+        fader->setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+        fader->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+        fader->setRange(0.0, 1.0, 0.0);
+        fader->setValue(1.0, juce::dontSendNotification);
+        fader->setPopupDisplayEnabled(true, false, this);
+    }
+
+    trimSlider1.onValueChange = [this]() { mixer.setChannelTrim(&effects1, (float)trimSlider1.getValue()); };
+    trimSlider2.onValueChange = [this]() { mixer.setChannelTrim(&effects2, (float)trimSlider2.getValue()); };
+    channelFader1.onValueChange = [this]() { mixer.setChannelFader(&effects1, (float)channelFader1.getValue()); };
+    channelFader2.onValueChange = [this]() { mixer.setChannelFader(&effects2, (float)channelFader2.getValue()); };
+
+    addAndMakeVisible(crossfaderSlider);
+    crossfaderSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    crossfaderSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    crossfaderSlider.setRange(0.0, 1.0, 0.0);
+    crossfaderSlider.setValue(mixer.getCrossfader(), juce::dontSendNotification);
+    crossfaderSlider.setDoubleClickReturnValue(true, 0.5);
+    crossfaderSlider.onValueChange = [this]() { mixer.setCrossfader((float)crossfaderSlider.getValue()); };
+
+    // Item ids are the curve's position in the enum, plus one
+    addAndMakeVisible(crossfaderCurveSelector);
+    crossfaderCurveSelector.addItem("Linear", 1);
+    crossfaderCurveSelector.addItem("Constant Power", 2);
+    crossfaderCurveSelector.addItem("Sharp Cut", 3);
+    crossfaderCurveSelector.setSelectedId((int)mixer.getCrossfaderCurve() + 1, juce::dontSendNotification);
+    crossfaderCurveSelector.onChange = [this]()
+    {
+        mixer.setCrossfaderCurve((OtoDecksAudio::DeckMixer::CrossfaderCurve)(crossfaderCurveSelector.getSelectedId() - 1));
+    };
+
+    // Item ids are the format's position in the enum, plus one; the compact formats halve a track's memory
+    addAndMakeVisible(sampleFormatSelector);
+    sampleFormatSelector.addItem("Float Samples", 1);
+    sampleFormatSelector.addItem("16-bit Samples", 2);
+    sampleFormatSelector.addItem("Half-Float Samples", 3);
+    sampleFormatSelector.setSelectedId((int)OtoDecksAudio::SampleStorage::Format::Float32 + 1, juce::dontSendNotification);
+    sampleFormatSelector.onChange = [this]()
+    {
+        const auto format = (OtoDecksAudio::SampleStorage::Format)(sampleFormatSelector.getSelectedId() - 1);
+        player1.setSampleFormat(format);
+        player2.setSampleFormat(format);
+    };
+
+    addAndMakeVisible(cueButton1);
+    addAndMakeVisible(cueButton2);
+    cueButton1.onClick = [this]() { mixer.setCue(&effects1, cueButton1.getToggleState()); };
+    cueButton2.onClick = [this]() { mixer.setCue(&effects2, cueButton2.getToggleState()); };
+
+    // Cue on the left, master on the right
+    addAndMakeVisible(cueMixSlider);
+    cueMixSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    cueMixSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+    cueMixSlider.setRange(0.0, 1.0, 0.0);
+    cueMixSlider.setValue(mixer.getCueMix(), juce::dontSendNotification);
+    cueMixSlider.onValueChange = [this]() { mixer.setCueMix((float)cueMixSlider.getValue()); };
+
+    for (auto* slot : { &effectSlot1, &effectSlot2 })
+    {
+        addAndMakeVisible(slot);
+        slot->addItemList({ "No Effect", "Filter", "Echo", "Reverb", "Flanger", "Bitcrush" }, 1);
+        slot->setSelectedId(1, juce::dontSendNotification);
+    }
+
+    for (auto* amount : { &effectAmount1, &effectAmount2 })
+    {
+        addAndMakeVisible(amount);
+        amount->setSliderStyle(juce::Slider::SliderStyle::Rotary);
+        amount->setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, true, 0, 0);
+        amount->setRange(0.0, 1.0, 0.0);
+        amount->setEnabled(false);
+    }
+
+    effectSlot1.onChange = [this]() { swapEffectInSlot(effectSlot1, effectAmount1, effects1, slotEffect1); };
+    effectSlot2.onChange = [this]() { swapEffectInSlot(effectSlot2, effectAmount2, effects2, slotEffect2); };
+    effectAmount1.onValueChange = [this]() { if (slotEffect1 != nullptr) setEffectAmount(*slotEffect1, (float)effectAmount1.getValue()); };
+    effectAmount2.onValueChange = [this]() { if (slotEffect2 != nullptr) setEffectAmount(*slotEffect2, (float)effectAmount2.getValue()); };
+
+    addAndMakeVisible(scanPluginsButton);
+    scanPluginsButton.onClick = [this]()
+    {
+        scanPluginsButton.setEnabled(false);
+        scanPluginsButton.setButtonText("Scanning...");
+        pluginHost.scanForPlugins();
+    };
+    pluginHost.onScanFinished = [this]()
+    {
+        scanPluginsButton.setEnabled(true);
+        scanPluginsButton.setButtonText("Scan Plugins");
+        refreshPluginSlots();
+    };
+
+    addAndMakeVisible(pluginSlot1);
+    addAndMakeVisible(pluginSlot2);
+    pluginSlot1.onChange = [this]() { loadPluginIntoSlot(pluginSlot1, effects1, pluginEffect1); };
+    pluginSlot2.onChange = [this]() { loadPluginIntoSlot(pluginSlot2, effects2, pluginEffect2); };
+    refreshPluginSlots();
+
+    addAndMakeVisible(parallelMixButton);
+    parallelMixButton.setToggleState(mixer.isRenderingInParallel(), juce::dontSendNotification);
+    parallelMixButton.onClick = [this]() { mixer.setParallelRendering(parallelMixButton.getToggleState()); };
+
     addAndMakeVisible(deckGUI1);
     addAndMakeVisible(deckGUI2);
+
+    // Each deck drops in on the other's bars when quantized
+    deckGUI1.setQuantizeReference(&player2);
+    deckGUI2.setQuantizeReference(&player1);
     addAndMakeVisible(playlistComponent);
     addAndMakeVisible(recordButton);
     recordButton.onClick = [this]()
@@ -71,20 +207,114 @@ MainComponent::~MainComponent()
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
     deviceSampleRate = sampleRate;
+    deviceBlockSize = samplesPerBlockExpected;
     deviceNumChannels = 2;
 
-    player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    mixer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    masterMeter.prepare(sampleRate);
+    recorder.getInputMeter().prepare(sampleRate);
+}
+
+void MainComponent::refreshPluginSlots()
+{
+    pluginTypes = pluginHost.getKnownPlugins().getTypes();
+
+    for (auto* slot : { &pluginSlot1, &pluginSlot2 })
+    {
+        // Keeps whatever is loaded, if it is still on the list
+        const auto loaded = slot->getText();
+
+        slot->clear(juce::dontSendNotification);
+        slot->addItem("No Plugin", 1);
+
+        for (int i = 0; i < pluginTypes.size(); ++i)
+            slot->addItem(pluginTypes.getReference(i).name, i + 2);
+
+        slot->setText(loaded.isEmpty() ? "No Plugin" : loaded, juce::dontSendNotification);
+    }
+}
+
+void MainComponent::loadPluginIntoSlot(juce::ComboBox& slot, OtoDecksAudio::DeckEffectsRack& rack,
+                                       OtoDecksAudio::DeckEffect*& slotEffect)
+{
+    // The old plugin rings out in the rack while the new one loads
+    if (slotEffect != nullptr)
+    {
+        rack.removeEffect(slotEffect);
+        slotEffect = nullptr;
+    }
+
+    const int selectedId = slot.getSelectedId();
+
+    if (selectedId < 2 || selectedId - 2 >= pluginTypes.size())
+        return;
+
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+
+    pluginHost.createEffect(pluginTypes.getReference(selectedId - 2), deviceSampleRate, deviceBlockSize, false,
+        [safeThis, &slot, &rack, &slotEffect, selectedId](std::unique_ptr<OtoDecksAudio::PluginEffect> effect, const juce::String& error)
+        {
+            // Gone, or another plugin was picked while this one loaded
+            if (safeThis == nullptr || slot.getSelectedId() != selectedId)
+                return;
+
+            if (effect == nullptr)
+            {
+                slot.setSelectedId(1, juce::dontSendNotification);
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Plugin", error);
+                return;
+            }
+
+            slotEffect = effect.get();
+            rack.addEffect(std::move(effect));
+        });
+}
+
+void MainComponent::swapEffectInSlot(juce::ComboBox& slot, juce::Slider& amount, OtoDecksAudio::DeckEffectsRack& rack,
+                                     OtoDecksAudio::DeckEffect*& slotEffect)
+{
+    // The old effect rings out in the rack while the new one takes over
+    if (slotEffect != nullptr)
+    {
+        rack.removeEffect(slotEffect);
+        slotEffect = nullptr;
+    }
+
+    switch (slot.getSelectedId())
+    {
+        case 2: slotEffect = rack.addEffect<OtoDecksAudio::FilterSweepEffect>(); break;
+        case 3: slotEffect = rack.addEffect<OtoDecksAudio::EchoEffect>(); break;
+        case 4: slotEffect = rack.addEffect<OtoDecksAudio::ReverbEffect>(); break;
+        case 5: slotEffect = rack.addEffect<OtoDecksAudio::FlangerEffect>(); break;
+        case 6: slotEffect = rack.addEffect<OtoDecksAudio::BitcrushEffect>(); break;
+        default: break;
+    }
+
+    amount.setEnabled(slotEffect != nullptr);
+
+    if (slotEffect == nullptr)
+        return;
+
+    // Ahead of the plugin, which stays last
+    rack.moveEffect(slotEffect, 0);
 
-    mixerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    // The knob picks up where the new effect starts: the filter open, the rest at their own mix
+    const bool isFilter = dynamic_cast<OtoDecksAudio::FilterSweepEffect*>(slotEffect) != nullptr;
+    amount.setValue(isFilter ? 0.5 : slotEffect->getMix(), juce::dontSendNotification);
+}
 
-    mixerSource.addInputSource(&player1, false);
-    mixerSource.addInputSource(&player2, false);
+void MainComponent::setEffectAmount(OtoDecksAudio::DeckEffect& effect, float amount)
+{
+    if (auto* filter = dynamic_cast<OtoDecksAudio::FilterSweepEffect*>(&effect))
+        filter->setPosition(amount * 2.0f - 1.0f);
+    else
+        effect.setMix(amount);
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {   
-    mixerSource.getNextAudioBlock(bufferToFill);
+    mixer.getNextAudioBlock(bufferToFill);
+    masterMeter.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
 
     // If recording, write the buffer to disk
     if (recorder.isRecording())
@@ -95,9 +325,7 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
 
 void MainComponent::releaseResources()
 {
-    player1.releaseResources();
-    player2.releaseResources();
-    mixerSource.releaseResources();
+    mixer.releaseResources();
 }
 
 void MainComponent::paint (juce::Graphics& g)
@@ -110,10 +338,45 @@ void MainComponent::resized()
     // Record button in the top center
     recordButton.setBounds((getWidth() - 30) / 2 - 6, 130, 30, 15);
 
-    deckGUI1.setBounds(0, 0, getWidth() / 2, getHeight() * 0.66 );
-    deckGUI2.setBounds(getWidth() / 2, 0, getWidth() / 2, getHeight() * 0.66);
+    deckGUI1.setBounds(0, 0, getWidth() / 2, getHeight() * 0.62 );
+    deckGUI2.setBounds(getWidth() / 2, 0, getWidth() / 2, getHeight() * 0.62);
+
+    // Crossfader in the strip between the decks and the playlist, its curve to the right
+    crossfaderSlider.setBounds(getWidth() / 3, getHeight() * 0.62, getWidth() / 3, getHeight() * 0.04);
+    crossfaderCurveSelector.setBounds(getWidth() * 2 / 3 + 10, getHeight() * 0.625, 140, getHeight() * 0.03);
+    sampleFormatSelector.setBounds(getWidth() * 2 / 3 + 160, getHeight() * 0.625, 150, getHeight() * 0.03);
+
+    // Cue switches and the cue/master blend to the left
+    cueButton1.setBounds(10, getHeight() * 0.625, 70, getHeight() * 0.03);
+    cueButton2.setBounds(85, getHeight() * 0.625, 70, getHeight() * 0.03);
+    cueMixSlider.setBounds(160, getHeight() * 0.62, getWidth() / 3 - 170, getHeight() * 0.04);
+
+    // Meters to the right of the playlist
+    const int meterWidth = 50;
+    auto meters = juce::Rectangle<int>(getWidth() - meterWidth * 4, getHeight() * 0.66, meterWidth * 4, getHeight() * 0.32);
+
+    for (auto* display : { &deckMeterDisplay1, &deckMeterDisplay2, &masterMeterDisplay, &recorderMeterDisplay })
+        display->setBounds(meters.removeFromLeft(meterWidth));
+
+    // Each deck's effect slot, its knob and its plugin slot in a row above the playlist
+    scanPluginsButton.setBounds(10, getHeight() * 0.665, 110, getHeight() * 0.03);
+    effectSlot1.setBounds(130, getHeight() * 0.665, 110, getHeight() * 0.03);
+    effectAmount1.setBounds(245, getHeight() * 0.66, 30, getHeight() * 0.04);
+    pluginSlot1.setBounds(280, getHeight() * 0.665, 130, getHeight() * 0.03);
+    effectSlot2.setBounds(420, getHeight() * 0.665, 110, getHeight() * 0.03);
+    effectAmount2.setBounds(535, getHeight() * 0.66, 30, getHeight() * 0.04);
+    pluginSlot2.setBounds(570, getHeight() * 0.665, 130, getHeight() * 0.03);
+    parallelMixButton.setBounds(710, getHeight() * 0.665, 85, getHeight() * 0.03);
 
-    playlistComponent.setBounds(0, getHeight() * 0.66, getWidth(), getHeight() * 0.32);
+    // Each deck's trim and channel fader in a row under them, deck 1 on the left
+    const int stripWidth = (getWidth() - meterWidth * 4) / 2;
+
+    trimSlider1.setBounds(10, getHeight() * 0.70, 40, getHeight() * 0.035);
+    channelFader1.setBounds(55, getHeight() * 0.70, stripWidth - 65, getHeight() * 0.035);
+    trimSlider2.setBounds(stripWidth + 10, getHeight() * 0.70, 40, getHeight() * 0.035);
+    channelFader2.setBounds(stripWidth + 55, getHeight() * 0.70, stripWidth - 65, getHeight() * 0.035);
+
+    playlistComponent.setBounds(0, getHeight() * 0.74, getWidth() - meterWidth * 4, getHeight() * 0.24);
 }
 
 bool DeckGUI::isInterestedInFileDrag(const juce::StringArray& files)
@@ -146,18 +409,30 @@ void DeckGUI::filesDropped(const juce::StringArray& files, int x, int y)
 
 void MainComponent::timerCallback()
 {
+    // Keeps beat-synced effects on each deck's tempo
+    effects1.setTempo(player1.getCurrentTempo());
+    effects2.setTempo(player2.getCurrentTempo());
+
+    // Lines the decks up behind whichever is delayed most by its plugins and key lock
+    auto getDeckLatency = [this](const DJAudioPlayer& player, const OtoDecksAudio::DeckEffectsRack& rack)
+    {
+        return rack.getLatencySamples() + (player.isKeyLocked() ? juce::roundToInt(player.getKeyLockLatency() * deviceSampleRate) : 0);
+    };
+
+    mixer.setVoiceLatency(&effects1, getDeckLatency(player1, effects1));
+    mixer.setVoiceLatency(&effects2, getDeckLatency(player2, effects2));
+
+    // The recorder's meter only means something while there's a take going
+    recorderMeterDisplay.setEnabled(recorder.isRecording());
+
     if (player1.isPlaying())
     {
         double length1 = player1.getLengthInSeconds();
         if (length1 > 0)
         {
+            // The player reports forward-timeline positions in both directions
             double currentPos1 = player1.getCurrentPosition();
-            double relativePos1 = 0.0;
-
-            if (player1.isReversed())
-                relativePos1 = 1.0 - (currentPos1 / length1);
-            else
-                relativePos1 = currentPos1 / length1;
+            double relativePos1 = currentPos1 / length1;
 
             relativePos1 = juce::jlimit(0.0, 1.0, relativePos1);
             deckGUI1.waveformDisplay.setPositionRelative(relativePos1);
@@ -169,13 +444,9 @@ void MainComponent::timerCallback()
         double length2 = player2.getLengthInSeconds();
         if (length2 > 0)
         {
+            // The player reports forward-timeline positions in both directions
             double currentPos2 = player2.getCurrentPosition();
-            double relativePos2 = 0.0;
-
-            if (player2.isReversed())
-                relativePos2 = 1.0 - (currentPos2 / length2);
-            else
-                relativePos2 = currentPos2 / length2;
+            double relativePos2 = currentPos2 / length2;
 
             relativePos2 = juce::jlimit(0.0, 1.0, relativePos2);
             deckGUI2.waveformDisplay.setPositionRelative(relativePos2);
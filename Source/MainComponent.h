@@ -3,6 +3,10 @@
 #include <JuceHeader.h>
 #include "DJAudioPlayer.h"
 #include "DeckGUI.h"
+#include "DeckMixer.h"
+#include "LevelMeterComponent.h"
+#include "DeckEffectsRack.h"
+#include "PluginHost.h"
 #include "PlaylistComponent.h"
 #include "CSVOperator.h"
 #include "LookAndFeel.h"
@@ -27,25 +31,95 @@ public:
 private:
     void timerCallback() override; 
 
+    // Plugin slots: one hosted plugin at the end of each deck's rack
+    void refreshPluginSlots();
+    void loadPluginIntoSlot(juce::ComboBox& slot, OtoDecksAudio::DeckEffectsRack& rack, OtoDecksAudio::DeckEffect*& slotEffect);
+
+    // Effect slots: a built-in effect at the front of each deck's rack, swapped for
+    // whichever is picked while the deck plays
+    void swapEffectInSlot(juce::ComboBox& slot, juce::Slider& amount, OtoDecksAudio::DeckEffectsRack& rack,
+                          OtoDecksAudio::DeckEffect*& slotEffect);
+
+    // The filter's knob sweeps it from low pass to high pass; every other effect's sets its mix
+    static void setEffectAmount(OtoDecksAudio::DeckEffect& effect, float amount);
+
     ModernLookAndFeel modernLookAndFeel;
 
     juce::AudioFormatManager formatManager;
     juce::AudioThumbnailCache thumbCache{ 100 };
+    DecodedTrackCache trackCache;
 
     PlaylistComponent playlistComponent;
-    DJAudioPlayer player1{formatManager};
+    DJAudioPlayer player1{formatManager, trackCache};
     DeckGUI deckGUI1{&player1, formatManager, thumbCache, &playlistComponent};
-    DJAudioPlayer player2{formatManager};
+    DJAudioPlayer player2{formatManager, trackCache};
     DeckGUI deckGUI2{&player2, formatManager, thumbCache, &playlistComponent};
-    juce::MixerAudioSource mixerSource;
+
+    // Finds and loads plugins for the effects racks
+    OtoDecksAudio::PluginHost pluginHost;
+
+    // Effects on the way from each deck to the mixer
+    OtoDecksAudio::DeckEffectsRack effects1{player1};
+    OtoDecksAudio::DeckEffectsRack effects2{player2};
+
+    // Levels going into the mixer from each deck, and coming out of it
+    OtoDecksAudio::LevelMeter deckMeter1;
+    OtoDecksAudio::LevelMeter deckMeter2;
+    OtoDecksAudio::LevelMeter masterMeter;
+
+    // Sums every deck; declared after them so it goes first
+    OtoDecksAudio::DeckMixer mixer;
+
+    // Each deck's channel strip in the mixer: trim knob and channel fader
+    juce::Slider trimSlider1;
+    juce::Slider trimSlider2;
+    juce::Slider channelFader1;
+    juce::Slider channelFader2;
+
+    // Crossfader, deck 1 on the left and deck 2 on the right
+    juce::Slider crossfaderSlider;
+    juce::ComboBox crossfaderCurveSelector;
+
+    // How both decks hold decoded tracks in memory, from the next load on
+    juce::ComboBox sampleFormatSelector;
+
+    // Headphone cue, heard on outputs 3/4 of devices that have them
+    juce::ToggleButton cueButton1{ "CUE 1" };
+    juce::ToggleButton cueButton2{ "CUE 2" };
+    juce::Slider cueMixSlider;
     CSVOperator csvOperator;
 
     // Recording feature
     RecordToggleSwitch recordButton;
     AudioRecorder recorder;
     double deviceSampleRate = 44100.0;
+    int deviceBlockSize = 512;
     int deviceNumChannels = 2;
     juce::File currentRecordingFile;
 
+    // Item 1 is no effect; the rest are the built-in effects, from id 2
+    juce::ComboBox effectSlot1;
+    juce::ComboBox effectSlot2;
+    juce::Slider effectAmount1;
+    juce::Slider effectAmount2;
+    OtoDecksAudio::DeckEffect* slotEffect1 = nullptr;
+    OtoDecksAudio::DeckEffect* slotEffect2 = nullptr;
+
+    // Item 1 is no plugin; the rest are pluginTypes in order, from id 2
+    juce::TextButton scanPluginsButton{ "Scan Plugins" };
+    juce::ComboBox pluginSlot1;
+    juce::ComboBox pluginSlot2;
+
+    // Renders the decks on separate cores, for when key lock and plugins make them heavy
+    juce::ToggleButton parallelMixButton{ "PARALLEL" };
+    juce::Array<juce::PluginDescription> pluginTypes;
+    OtoDecksAudio::DeckEffect* pluginEffect1 = nullptr;
+    OtoDecksAudio::DeckEffect* pluginEffect2 = nullptr;
+
+    LevelMeterComponent deckMeterDisplay1{ deckMeter1, "DECK 1" };
+    LevelMeterComponent deckMeterDisplay2{ deckMeter2, "DECK 2" };
+    LevelMeterComponent masterMeterDisplay{ masterMeter, "MASTER" };
+    LevelMeterComponent recorderMeterDisplay{ recorder.getInputMeter(), "REC" };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
\ No newline at end of file
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    MappedSamples.cpp
+
+  ==============================================================================
+*/
+
+#include "MappedSamples.h"
+
+namespace OtoDecksAudio
+{
+    std::unique_ptr<MappedSamples> MappedSamples::create(juce::AudioFormatManager& formatManager,
+                                                         const juce::File& file,
+                                                         double lookAheadSeconds,
+                                                         juce::TimeSliceThread& readAheadThread)
+    {
+        auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+
+        if (format == nullptr)
+            return nullptr;
+
+        // Only formats that store plain PCM frames hand out a memory-mapped reader
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(file));
+
+        if (reader == nullptr || reader->numChannels == 0 || (int)reader->numChannels > maxChannels
+             || reader->lengthInSamples <= 0 || !reader->mapEntireFile())
+            return nullptr;
+
+        return std::unique_ptr<MappedSamples>(new MappedSamples(std::move(reader), lookAheadSeconds, readAheadThread));
+    }
+
+    MappedSamples::MappedSamples(std::unique_ptr<juce::MemoryMappedAudioFormatReader> readerToUse,
+                                 double lookAheadSeconds,
+                                 juce::TimeSliceThread& readAheadThread)
+        : reader(std::move(readerToUse)),
+          thread(readAheadThread),
+          lookAhead((juce::int64)(juce::jlimit(1.0, 300.0, lookAheadSeconds) * reader->sampleRate)),
+          samplesPerPage(juce::jmax(1, 4096 / juce::jmax(1, (int)(reader->numChannels * reader->bitsPerSample / 8))))
+    {
+        for (auto& pin : pins)
+            pin = -1;
+
+        thread.addTimeSliceClient(this);
+    }
+
+    MappedSamples::~MappedSamples()
+    {
+        thread.removeTimeSliceClient(this);
+    }
+
+    //==============================================================================
+    bool MappedSamples::read(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        // The reader fills whichever channels have a destination and skips the rest,
+        // converting straight from the mapped file into dest
+        float* channels[maxChannels] = {};
+        channels[channel] = dest;
+
+        reader->read(channels, channel + 1, startSample, numToRead);
+
+        if (gain != 1.0f)
+            juce::FloatVectorOperations::multiply(dest, gain, numToRead);
+
+        return true;
+    }
+
+    bool MappedSamples::addTo(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        constexpr int pieceSize = 256;
+        float piece[pieceSize];
+
+        for (int offset = 0; offset < numToRead; offset += pieceSize)
+        {
+            const int num = juce::jmin(pieceSize, numToRead - offset);
+            read(channel, startSample + offset, piece, num, gain);
+            juce::FloatVectorOperations::add(dest + offset, piece, num);
+        }
+
+        return true;
+    }
+
+    void MappedSamples::setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept
+    {
+        juce::ignoreUnused(playhead);
+
+        requestedPosition.store(position, std::memory_order_relaxed);
+        requestedBackwards.store(backwards, std::memory_order_relaxed);
+    }
+
+    void MappedSamples::pinRegion(int slot, juce::int64 startSample)
+    {
+        if (juce::isPositiveAndBelow(slot, maxPinnedRegions))
+        {
+            pins[(size_t)slot].store(startSample < 0 ? -1 : juce::jmin(startSample, reader->lengthInSamples), std::memory_order_relaxed);
+            pinsChanged = true;
+        }
+    }
+
+    //==============================================================================
+    int MappedSamples::useTimeSlice()
+    {
+        constexpr int pagesPerSlice = 64;
+
+        const auto numSamples = reader->lengthInSamples;
+        const auto target = juce::jlimit((juce::int64)0, numSamples, requestedPosition.load(std::memory_order_relaxed));
+        const bool backwards = requestedBackwards.load(std::memory_order_relaxed);
+
+        // Start again from the playhead if it has jumped out of the touched range
+        if (target < touchedStart || target > touchedEnd)
+            touchedStart = touchedEnd = target;
+
+        const auto sliceLength = (juce::int64)samplesPerPage * pagesPerSlice;
+
+        if (!backwards && touchedEnd < juce::jmin(numSamples, target + lookAhead))
+        {
+            const auto end = juce::jmin(numSamples, target + lookAhead, touchedEnd + sliceLength);
+
+            for (auto sample = touchedEnd; sample < end; sample += samplesPerPage)
+                reader->touchSample(sample);
+
+            touchedEnd = end;
+            touchedStart = juce::jmax(touchedStart, touchedEnd - lookAhead * 2);
+            return 0;
+        }
+
+        if (backwards && touchedStart > juce::jmax((juce::int64)0, target - lookAhead))
+        {
+            const auto start = juce::jmax((juce::int64)0, target - lookAhead, touchedStart - sliceLength);
+
+            for (auto sample = start; sample < touchedStart; sample += samplesPerPage)
+                reader->touchSample(sample);
+
+            touchedStart = start;
+            touchedEnd = juce::jmin(touchedEnd, touchedStart + lookAhead * 2);
+            return 0;
+        }
+
+        touchPins();
+        return 20;
+    }
+
+    void MappedSamples::touchPins()
+    {
+        const auto now = juce::Time::getMillisecondCounter();
+
+        if (!pinsChanged.exchange(false) && now - lastPinTouch < pinRefreshMs)
+            return;
+
+        lastPinTouch = now;
+
+        const auto numSamples = reader->lengthInSamples;
+        const auto pinLength = (juce::int64)(pinnedSeconds * reader->sampleRate);
+
+        for (const auto& pin : pins)
+        {
+            const auto start = pin.load(std::memory_order_relaxed);
+
+            if (start < 0)
+                continue;
+
+            for (auto sample = start; sample < juce::jmin(numSamples, start + pinLength); sample += samplesPerPage)
+                reader->touchSample(sample);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    MappedSamples.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TrackSamples.h"
+
+namespace OtoDecksAudio
+{
+    // Plays an uncompressed WAV or AIFF file straight out of a memory-mapped view of it.
+    // Nothing is decoded up front: samples are converted to float as they are read, and
+    // the audio itself stays in the OS page cache, shared with anything else reading
+    // the same file.
+    //
+    // So the audio thread doesn't stall on page faults, the read-ahead thread touches
+    // the pages just ahead of the playhead before it gets there, and every so often the
+    // pages after each pinned position so the OS keeps them around.
+    class MappedSamples : public TrackSamples,
+                          private juce::TimeSliceClient
+    {
+    public:
+        // Returns nullptr if the file isn't a format that can be mapped, or mapping fails
+        static std::unique_ptr<MappedSamples> create(juce::AudioFormatManager& formatManager,
+                                                     const juce::File& file,
+                                                     double lookAheadSeconds,
+                                                     juce::TimeSliceThread& readAheadThread);
+        ~MappedSamples() override;
+
+        double getSampleRate() const noexcept { return reader->sampleRate; }
+
+        int getNumChannels() const noexcept override { return (int)reader->numChannels; }
+        juce::int64 getNumSamples() const noexcept override { return reader->lengthInSamples; }
+
+        bool read(int channel, juce::int64 startSample, float* dest, int numToRead, float gain = 1.0f) const override;
+        bool addTo(int channel, juce::int64 startSample, float* dest, int numToRead, float gain = 1.0f) const override;
+        void setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept override;
+        void pinRegion(int slot, juce::int64 startSample) override;
+
+        // Mapped pages belong to the page cache, not to this track
+        size_t getSizeInBytes() const noexcept override { return 0; }
+
+    private:
+        MappedSamples(std::unique_ptr<juce::MemoryMappedAudioFormatReader> readerToUse,
+                      double lookAheadSeconds,
+                      juce::TimeSliceThread& readAheadThread);
+
+        int useTimeSlice() override;
+        void touchPins();
+
+        // Channels a single read can pick from
+        static constexpr int maxChannels = 64;
+
+        // How much after each pinned position is kept touched, and how often
+        static constexpr double pinnedSeconds = 2.0;
+        static constexpr juce::uint32 pinRefreshMs = 1000;
+
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+        juce::TimeSliceThread& thread;
+
+        const juce::int64 lookAhead;
+        const int samplesPerPage;
+
+        // Where the audio thread says playback is heading
+        std::atomic<juce::int64> requestedPosition { 0 };
+        std::atomic<bool> requestedBackwards { false };
+
+        // Read-ahead thread only: the range of the file already touched
+        juce::int64 touchedStart = 0;
+        juce::int64 touchedEnd = 0;
+
+        std::array<std::atomic<juce::int64>, maxPinnedRegions> pins;
+        std::atomic<bool> pinsChanged { false };
+
+        // Read-ahead thread only
+        juce::uint32 lastPinTouch = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MappedSamples)
+    };
+}
@@ -1,13 +1,14 @@
 #pragma once
 #include <JuceHeader.h>
+#include "TrackSamples.h"
 
 namespace OtoDecksAudio
 {
     class MemoryAudioSource : public juce::PositionableAudioSource
     {
     public:
-        MemoryAudioSource(const juce::AudioBuffer<float>& bufferToUse, bool shouldLoop)
-            : buffer(bufferToUse), looping(shouldLoop)
+        MemoryAudioSource(const TrackSamples& samplesToUse, bool shouldLoop)
+            : samples(samplesToUse), looping(shouldLoop)
         {
             position = 0;
         }
@@ -21,53 +22,114 @@ namespace OtoDecksAudio
 
         void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override
         {
-            auto numChannels = buffer.getNumChannels();
-            auto numSamples = bufferToFill.numSamples;
-            auto* outputBuffer = bufferToFill.buffer;
+            const juce::int64 length = samples.getNumSamples();
 
-            for (int channel = 0; channel < outputBuffer->getNumChannels(); ++channel)
+            if (samples.getNumChannels() == 0 || length == 0)
             {
-                float* writePtr = outputBuffer->getWritePointer(channel, bufferToFill.startSample);
-                for (int i = 0; i < numSamples; ++i)
+                bufferToFill.clearActiveBufferRegion();
+                return;
+            }
+
+            const bool playBackwards = reversed.load();
+            int outputOffset = bufferToFill.startSample;
+            int remaining = bufferToFill.numSamples;
+
+            if (playBackwards)
+                position = juce::jmin(position, length);
+
+            const juce::int64 loopFirst = juce::jmin(loopStart, length);
+            const juce::int64 loopLast = loopEnd < 0 ? length : juce::jmin(loopEnd, length);
+
+            // Split the block into contiguous runs of the buffer. A run only ends early
+            // where playback wraps around a loop or runs off the end.
+            while (remaining > 0)
+            {
+                const juce::int64 lower = looping && position >= loopFirst ? loopFirst : 0;
+                const juce::int64 upper = looping && position <= loopLast ? loopLast : length;
+                const juce::int64 available = playBackwards ? position - lower : upper - position;
+
+                if (available <= 0)
                 {
-                    if (position >= buffer.getNumSamples())
+                    if (looping && loopLast > loopFirst)
                     {
-                        if (looping)
-                            position = 0;
-                        else
-                        {
-                            writePtr[i] = 0.0f;
-                            continue;
-                        }
+                        position = playBackwards ? loopLast : loopFirst;
+                        continue;
                     }
 
-                    writePtr[i] = buffer.getSample(channel % numChannels, position);
-                    ++position;
+                    bufferToFill.buffer->clear(outputOffset, remaining);
+
+                    // Keep counting past the end so a transport can tell the stream has finished
+                    if (!playBackwards)
+                        position += remaining;
+
+                    break;
                 }
+
+                const int runLength = (int)juce::jmin((juce::int64)remaining, available);
+                const juce::int64 runStart = playBackwards ? position - runLength : position;
+
+                copyRun(*bufferToFill.buffer, outputOffset, runStart, runLength, playBackwards);
+
+                position += playBackwards ? -runLength : runLength;
+                outputOffset += runLength;
+                remaining -= runLength;
             }
         }
 
-        void setPosition(int newPosition) 
+        // Plays the buffer backwards from the current position. The position marks the
+        // boundary between two samples, so switching direction replays nothing and skips nothing.
+        void setReversed(bool shouldPlayBackwards)
+        {
+            reversed = shouldPlayBackwards;
+        }
+
+        bool isReversed() const { return reversed.load(); }
+
+        // Loops between two sample boundaries rather than round the whole buffer. Playback
+        // from outside the range carries on until it crosses in; from beyond the end it
+        // runs to the end of the buffer first. An end of -1 means the end of the buffer.
+        // Call before playback starts or from the audio thread.
+        void setLooping(bool shouldLoop)
+        {
+            looping = shouldLoop;
+        }
+
+        void setLoopRange(juce::int64 start, juce::int64 end)
         {
-            position = juce::jlimit(0, buffer.getNumSamples() - 1, newPosition);
+            loopStart = juce::jmax((juce::int64)0, start);
+            loopEnd = end;
         }
 
-        int getPosition() const { return position; }
+        // True once a non-looping source has run off the end it is playing towards
+        bool hasFinished() const
+        {
+            if (looping)
+                return false;
+
+            return reversed.load() ? position <= 0 : position >= samples.getNumSamples();
+        }
+
+        void setPosition(juce::int64 newPosition)
+        {
+            position = juce::jlimit((juce::int64)0, samples.getNumSamples(), newPosition);
+        }
+
+        juce::int64 getPosition() const { return position; }
 
         // Implement pure virtual methods of PositionableAudioSource:
-        void setNextReadPosition(int64 newPosition) override
+        void setNextReadPosition(juce::int64 newPosition) override
         {
-            position = juce::jlimit(0, buffer.getNumSamples() - 1, (int)newPosition);
+            setPosition(newPosition);
         }
 
-        int64 getNextReadPosition() const override
+        juce::int64 getNextReadPosition() const override
         {
             return position;
         }
 
-        int64 getTotalLength() const override
+        juce::int64 getTotalLength() const override
         {
-            return buffer.getNumSamples();
+            return samples.getNumSamples();
         }
 
         bool isLooping() const override
@@ -81,9 +143,49 @@ namespace OtoDecksAudio
         }
 
     private:
-        const juce::AudioBuffer<float>& buffer;
-        int position = 0;
+        // Copies one contiguous run of source samples into the output, mixing channels
+        // as needed. Backwards runs are copied forwards and then flipped in place.
+        void copyRun(juce::AudioBuffer<float>& output, int outputOffset, juce::int64 sourceStart, int numSamples, bool backwards) const
+        {
+            const int numOutputChannels = output.getNumChannels();
+            const int numSourceChannels = samples.getNumChannels();
+
+            if (numOutputChannels == 1 && numSourceChannels > 1)
+            {
+                // Down-mix to mono by averaging every source channel
+                float* dest = output.getWritePointer(0, outputOffset);
+                const float scale = 1.0f / (float)numSourceChannels;
+
+                samples.read(0, sourceStart, dest, numSamples, scale);
+
+                for (int channel = 1; channel < numSourceChannels; ++channel)
+                    samples.addTo(channel, sourceStart, dest, numSamples, scale);
+            }
+            else
+            {
+                // Matching layouts copy straight across; extra outputs repeat the source channels,
+                // so a mono track plays on both sides of a stereo output
+                for (int channel = 0; channel < numOutputChannels; ++channel)
+                    samples.read(channel % numSourceChannels, sourceStart,
+                                 output.getWritePointer(channel, outputOffset), numSamples);
+            }
+
+            if (backwards)
+            {
+                for (int channel = 0; channel < numOutputChannels; ++channel)
+                {
+                    float* dest = output.getWritePointer(channel, outputOffset);
+                    std::reverse(dest, dest + numSamples);
+                }
+            }
+        }
+
+        const TrackSamples& samples;
+        juce::int64 position = 0;
         bool looping = false;
+        juce::int64 loopStart = 0;
+        juce::int64 loopEnd = -1;
+        std::atomic<bool> reversed { false };
         double sampleRate = 44100.0;
     };
 }
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterRamp.h"
+#include "SimdHelpers.h"
+
+namespace OtoDecksAudio
+{
+    void ParameterRamp::prepare(double newSampleRate, double rampSeconds)
+    {
+        sampleRate = newSampleRate;
+        setRampTime(rampSeconds);
+        setCurrentAndTarget(target);
+    }
+
+    void ParameterRamp::setRampTime(double rampSeconds) noexcept
+    {
+        rampSamples = juce::jmax(0, juce::roundToInt(rampSeconds * sampleRate));
+    }
+
+    void ParameterRamp::setTarget(float newTarget) noexcept
+    {
+        if (newTarget == target)
+            return;
+
+        target = newTarget;
+
+        if (rampSamples == 0)
+        {
+            setCurrentAndTarget(newTarget);
+            return;
+        }
+
+        // A new target restarts the glide from wherever it has got to
+        step = (target - current) / (float)rampSamples;
+        stepsRemaining = rampSamples;
+    }
+
+    void ParameterRamp::setCurrentAndTarget(float newValue) noexcept
+    {
+        current = target = newValue;
+        step = 0.0f;
+        stepsRemaining = 0;
+    }
+
+    void ParameterRamp::applyGain(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+    {
+        const int numRamped = juce::jmin(stepsRemaining, numSamples);
+        const int numSettled = numSamples - numRamped;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            float* samples = buffer.getWritePointer(channel, startSample);
+
+            if (numRamped > 0)
+                applyLinearRamp(samples, numRamped, current, step);
+
+            if (numSettled > 0 && target != 1.0f)
+            {
+                if (target == 0.0f)
+                    juce::FloatVectorOperations::clear(samples + numRamped, numSettled);
+                else
+                    juce::FloatVectorOperations::multiply(samples + numRamped, target, numSettled);
+            }
+        }
+
+        advance(numRamped);
+    }
+
+    void ParameterRamp::addWithGain(juce::AudioBuffer<float>& dest, int destStartSample,
+                                    const juce::AudioBuffer<float>& source, int sourceStartSample,
+                                    int numChannels, int numSamples) noexcept
+    {
+        // More than any bus here carries
+        constexpr int maxChannels = 8;
+        float* out[maxChannels] = {};
+        const float* in[maxChannels] = {};
+
+        numChannels = juce::jmin(numChannels, maxChannels);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            out[channel] = dest.getWritePointer(channel, destStartSample);
+            in[channel] = source.getReadPointer(channel, sourceStartSample);
+        }
+
+        addWithGain(out, in, numChannels, numSamples);
+    }
+
+    void ParameterRamp::addWithGain(float* const* dest, const float* const* source, int numChannels, int numSamples) noexcept
+    {
+        const int numRamped = juce::jmin(stepsRemaining, numSamples);
+        const int numSettled = numSamples - numRamped;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* out = dest[channel];
+            const float* in = source[channel];
+
+            if (numRamped > 0)
+                addWithLinearRamp(out, in, numRamped, current, step);
+
+            if (numSettled > 0 && target != 0.0f)
+            {
+                if (target == 1.0f)
+                    juce::FloatVectorOperations::add(out + numRamped, in + numRamped, numSettled);
+                else
+                    juce::FloatVectorOperations::addWithMultiply(out + numRamped, in + numRamped, target, numSettled);
+            }
+        }
+
+        advance(numRamped);
+    }
+
+    void ParameterRamp::advance(int numRamped) noexcept
+    {
+        stepsRemaining -= numRamped;
+
+        // Land exactly on the target so the settled part is a clean copy
+        current = stepsRemaining > 0 ? current + step * (float)numRamped : target;
+    }
+
+    void ParameterRamp::applyLinearRamp(float* samples, int numSamples, float startGain, float gainStep) noexcept
+    {
+        int i = 0;
+
+        // Each gain is worked out from its index rather than accumulated, so long ramps don't drift
+       #if OTODECKS_USE_SSE2
+        const __m128 stepV = _mm_set1_ps(gainStep);
+        const __m128 offsets = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 gain = _mm_add_ps(_mm_set1_ps(startGain), _mm_mul_ps(stepV, _mm_add_ps(_mm_set1_ps((float)i), offsets)));
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        }
+       #elif OTODECKS_USE_NEON
+        const float offsetValues[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        const float32x4_t offsets = vld1q_f32(offsetValues);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float32x4_t gain = vmlaq_n_f32(vdupq_n_f32(startGain), vaddq_f32(vdupq_n_f32((float)i), offsets), gainStep);
+            vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), gain));
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            samples[i] *= startGain + gainStep * (float)(i + 1);
+    }
+
+    void ParameterRamp::addWithLinearRamp(float* dest, const float* source, int numSamples, float startGain, float gainStep) noexcept
+    {
+        int i = 0;
+
+       #if OTODECKS_USE_SSE2
+        const __m128 stepV = _mm_set1_ps(gainStep);
+        const __m128 offsets = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 gain = _mm_add_ps(_mm_set1_ps(startGain), _mm_mul_ps(stepV, _mm_add_ps(_mm_set1_ps((float)i), offsets)));
+            _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(source + i), gain)));
+        }
+       #elif OTODECKS_USE_NEON
+        const float offsetValues[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        const float32x4_t offsets = vld1q_f32(offsetValues);
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const float32x4_t gain = vmlaq_n_f32(vdupq_n_f32(startGain), vaddq_f32(vdupq_n_f32((float)i), offsets), gainStep);
+            vst1q_f32(dest + i, vmlaq_f32(vld1q_f32(dest + i), vld1q_f32(source + i), gain));
+        }
+       #endif
+
+        for (; i < numSamples; ++i)
+            dest[i] += source[i] * (startGain + gainStep * (float)(i + 1));
+    }
+}
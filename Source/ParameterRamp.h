@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // A gain that glides in a straight line to each new target over a fixed time, so
+    // fader moves and mutes never step. It is applied a block at a time: the gliding
+    // part as one vectorized ramp per channel, and whatever is left of the block at the
+    // target as a plain multiply, or nothing at all once it has settled at one.
+    class ParameterRamp
+    {
+    public:
+        explicit ParameterRamp(float initialValue = 1.0f) noexcept
+            : current(initialValue), target(initialValue) {}
+
+        void prepare(double newSampleRate, double rampSeconds);
+
+        // Takes effect from the next target
+        void setRampTime(double rampSeconds) noexcept;
+
+        void setTarget(float newTarget) noexcept;
+
+        // Jumps straight to the value, abandoning any glide
+        void setCurrentAndTarget(float newValue) noexcept;
+
+        float getCurrent() const noexcept { return current; }
+        float getTarget() const noexcept { return target; }
+        bool isRamping() const noexcept { return stepsRemaining > 0; }
+
+        // For callers that apply the ramp themselves: while it glides, the i-th sample from
+        // here has a value of getCurrent() + getStep() * (i + 1), for getRemainingSteps() samples
+        float getStep() const noexcept { return stepsRemaining > 0 ? step : 0.0f; }
+        int getRemainingSteps() const noexcept { return stepsRemaining; }
+
+        // Moves the ramp on by numSamples without applying it
+        void skip(int numSamples) noexcept { advance(juce::jmin(stepsRemaining, numSamples)); }
+
+        // Scales numSamples of every channel by the ramp, and moves it on by as much
+        void applyGain(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+        // Adds numSamples of the first numChannels of source into dest, scaled by the ramp on
+        // the way, and moves it on by as much. Silence is skipped once it has settled at zero.
+        void addWithGain(juce::AudioBuffer<float>& dest, int destStartSample,
+                         const juce::AudioBuffer<float>& source, int sourceStartSample,
+                         int numChannels, int numSamples) noexcept;
+
+        // The same on raw channel pointers, for channels that don't start a buffer
+        void addWithGain(float* const* dest, const float* const* source, int numChannels, int numSamples) noexcept;
+
+        // Multiplies samples by a gain of startGain + gainStep * (i + 1) for the i-th sample
+        static void applyLinearRamp(float* samples, int numSamples, float startGain, float gainStep) noexcept;
+
+        // Adds source to dest with the same gain as applyLinearRamp
+        static void addWithLinearRamp(float* dest, const float* source, int numSamples, float startGain, float gainStep) noexcept;
+
+    private:
+        void advance(int numRamped) noexcept;
+
+        double sampleRate = 44100.0;
+        int rampSamples = 0;
+
+        float current;
+        float target;
+        float step = 0.0f;
+        int stepsRemaining = 0;
+    };
+}
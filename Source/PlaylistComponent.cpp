@@ -346,8 +346,11 @@ juce::Component* PlaylistComponent::refreshComponentForCell(int rowNumber, int c
                 // Update CSV and internal struct immediately
                 if (originalIndex < (int)tracks.size())
                 {
-                    tracks[originalIndex].note = trackNotes[originalIndex].toStdString();
-                    CSVOperator::saveAllTracks(tracks);
+                    auto& track = tracks[originalIndex];
+                    track.note = trackNotes[originalIndex].toStdString();
+
+                    // Only this row changes; a deck may have saved hot cues since the list was read
+                    CSVOperator::updateTrack(track.path, [&track](TrackInfo& info) { info.note = track.note; });
                 }
             }
         };
@@ -380,10 +383,10 @@ juce::Component* PlaylistComponent::refreshComponentForCell(int rowNumber, int c
 
         heartButton->setImages(fav ? filledHeart.get() : outlineHeart.get());
 
-        heartButton->onClick = [this, heartButton, rowNumber]()
+        heartButton->onClick = [this, heartButton, trackIndex]()
         {
             bool newState = heartButton->getToggleState();
-            isFavorite[rowNumber] = newState;
+            isFavorite[trackIndex] = newState;
 
             if (newState)
                 heartButton->setImages(filledHeart.get());
@@ -391,10 +394,11 @@ juce::Component* PlaylistComponent::refreshComponentForCell(int rowNumber, int c
                 heartButton->setImages(outlineHeart.get());
 
             // Update CSV and internal tracks vector immediately
-            if (rowNumber < (int)tracks.size())
+            if (trackIndex < (int)tracks.size())
             {
-                tracks[rowNumber].favorite = newState;
-                CSVOperator::saveAllTracks(tracks);
+                auto& track = tracks[trackIndex];
+                track.favorite = newState;
+                CSVOperator::updateTrack(track.path, [newState](TrackInfo& info) { info.favorite = newState; });
             }
         };
         return heartButton;
@@ -0,0 +1,286 @@
+/*
+  ==============================================================================
+
+    PluginEffect.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginEffect.h"
+
+namespace OtoDecksAudio
+{
+    // Sleeps until the audio thread hands over a block, then runs the plugin over it
+    class PluginEffect::Worker : public juce::Thread
+    {
+    public:
+        explicit Worker(PluginEffect& effectToRun)
+            : juce::Thread("Plugin worker"), effect(effectToRun) {}
+
+        // Audio thread; never takes a lock
+        void wake() noexcept { semaphore.signal(); }
+
+        void stop()
+        {
+            signalThreadShouldExit();
+            wake();
+            stopThread(2000);
+        }
+
+    private:
+        void run() override
+        {
+            juce::ScopedNoDenormals noDenormals;
+
+            while (!threadShouldExit())
+            {
+                semaphore.wait();
+
+                if (!threadShouldExit())
+                    effect.processPending();
+            }
+        }
+
+        PluginEffect& effect;
+        RealtimeSemaphore semaphore;
+    };
+
+    //==============================================================================
+    PluginEffect::PluginEffect(std::unique_ptr<juce::AudioPluginInstance> pluginToHost, bool processOnWorkerThread)
+        : DeckEffect(1.0f),
+          plugin(std::move(pluginToHost)),
+          onWorkerThread(processOnWorkerThread)
+    {
+        // Plugins that can't do plain stereo in and out keep their own layout
+        juce::AudioProcessor::BusesLayout stereo;
+        stereo.inputBuses.add(juce::AudioChannelSet::stereo());
+        stereo.outputBuses.add(juce::AudioChannelSet::stereo());
+        plugin->setBusesLayout(stereo);
+    }
+
+    PluginEffect::~PluginEffect()
+    {
+        if (worker != nullptr)
+            worker->stop();
+
+        plugin->releaseResources();
+    }
+
+    int PluginEffect::getLatencySamples() const noexcept
+    {
+        return plugin->getLatencySamples() + (onWorkerThread ? maximumBlockSize : 0);
+    }
+
+    void PluginEffect::prepareEffect()
+    {
+        if (worker != nullptr)
+            worker->stop();
+
+        plugin->releaseResources();
+        plugin->setRateAndBufferSizeDetails(sampleRate, maximumBlockSize);
+        plugin->prepareToPlay(sampleRate, maximumBlockSize);
+
+        pluginBuffer.setSize(juce::jmax(2, plugin->getTotalNumInputChannels(), plugin->getTotalNumOutputChannels()), maximumBlockSize);
+        midi.ensureSize(256);
+
+        if (!onWorkerThread)
+            return;
+
+        // Room for a few blocks each way, with a block of silence already on its way back
+        const int capacity = maximumBlockSize * 4 + 1;
+
+        toWorker.setTotalSize(capacity);
+        fromWorker.setTotalSize(capacity);
+        toWorkerBuffer.setSize(maxChannels, capacity);
+        fromWorkerBuffer.setSize(maxChannels, capacity);
+        fromWorkerBuffer.clear();
+
+        int start1, size1, start2, size2;
+        fromWorker.prepareToWrite(maximumBlockSize, start1, size1, start2, size2);
+        fromWorker.finishedWrite(size1 + size2);
+        samplesOwed = 0;
+
+        if (worker == nullptr)
+            worker = std::make_unique<Worker>(*this);
+
+        worker->startRealtimeThread(juce::Thread::RealtimeOptions{});
+    }
+
+    void PluginEffect::reset() noexcept
+    {
+        plugin->reset();
+    }
+
+    //==============================================================================
+    void PluginEffect::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context&) noexcept
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+
+        if (numChannels == 0)
+            return;
+
+        float* channels[maxChannels] = {};
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = buffer.getWritePointer(channel, startSample);
+
+        if (onWorkerThread)
+            processOnWorker(channels, numChannels, numSamples);
+        else
+            processDirect(channels, numChannels, numSamples);
+    }
+
+    void PluginEffect::processDirect(float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        const int numPluginChannels = pluginBuffer.getNumChannels();
+        const int numOutputs = plugin->getTotalNumOutputChannels();
+
+        for (int offset = 0; offset < numSamples; offset += maximumBlockSize)
+        {
+            const int num = juce::jmin(maximumBlockSize, numSamples - offset);
+
+            // A mono deck feeds both sides of a stereo plugin
+            for (int channel = 0; channel < numPluginChannels; ++channel)
+            {
+                if (channel < maxChannels)
+                    juce::FloatVectorOperations::copy(pluginBuffer.getWritePointer(channel), channels[juce::jmin(channel, numChannels - 1)] + offset, num);
+                else
+                    juce::FloatVectorOperations::clear(pluginBuffer.getWritePointer(channel), num);
+            }
+
+            // Refers to pluginBuffer's channels, so nothing is allocated
+            juce::AudioBuffer<float> block(pluginBuffer.getArrayOfWritePointers(), numPluginChannels, num);
+            midi.clear();
+            plugin->processBlock(block, midi);
+
+            // A mono plugin feeds both sides of a stereo deck
+            if (numOutputs > 0)
+                for (int channel = 0; channel < numChannels; ++channel)
+                    juce::FloatVectorOperations::copy(channels[channel] + offset, pluginBuffer.getReadPointer(juce::jmin(channel, numOutputs - 1)), num);
+        }
+    }
+
+    void PluginEffect::processOnWorker(float* const* channels, int numChannels, int numSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+
+        // Input the worker has fallen too far behind to take is dropped. Its output will
+        // never come, so as much silence is owed in its place.
+        toWorker.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < maxChannels; ++channel)
+        {
+            const float* source = channels[juce::jmin(channel, numChannels - 1)];
+
+            if (size1 > 0)
+                juce::FloatVectorOperations::copy(toWorkerBuffer.getWritePointer(channel, start1), source, size1);
+
+            if (size2 > 0)
+                juce::FloatVectorOperations::copy(toWorkerBuffer.getWritePointer(channel, start2), source + size1, size2);
+        }
+
+        toWorker.finishedWrite(size1 + size2);
+        samplesOwed -= numSamples - (size1 + size2);
+        worker->wake();
+
+        // Output that turned up too late to play was replaced by silence, so it's thrown
+        // away here rather than played late, which would add to the latency for good
+        if (samplesOwed > 0)
+        {
+            const int numLate = juce::jmin(samplesOwed, fromWorker.getNumReady());
+            fromWorker.prepareToRead(numLate, start1, size1, start2, size2);
+            fromWorker.finishedRead(size1 + size2);
+            samplesOwed -= size1 + size2;
+        }
+
+        // Silence stands in for output that was dropped on its way in
+        int numSilent = 0;
+
+        if (samplesOwed < 0)
+        {
+            numSilent = juce::jmin(-samplesOwed, numSamples);
+            samplesOwed += numSilent;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::clear(channels[channel], numSilent);
+        }
+
+        const int numWanted = numSamples - numSilent;
+        fromWorker.prepareToRead(numWanted, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* dest = channels[channel] + numSilent;
+
+            if (size1 > 0)
+                juce::FloatVectorOperations::copy(dest, fromWorkerBuffer.getReadPointer(channel, start1), size1);
+
+            if (size2 > 0)
+                juce::FloatVectorOperations::copy(dest + size1, fromWorkerBuffer.getReadPointer(channel, start2), size2);
+        }
+
+        fromWorker.finishedRead(size1 + size2);
+
+        // The worker is late. What it hasn't finished is played as silence and skipped
+        // once it turns up, so the latency stays where getLatencySamples says it is.
+        const int numMissing = numWanted - (size1 + size2);
+
+        if (numMissing > 0)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::clear(channels[channel] + numSamples - numMissing, numMissing);
+
+            samplesOwed += numMissing;
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void PluginEffect::processPending() noexcept
+    {
+        for (;;)
+        {
+            const int num = juce::jmin(toWorker.getNumReady(), fromWorker.getFreeSpace(), maximumBlockSize);
+
+            if (num <= 0)
+                return;
+
+            int start1, size1, start2, size2;
+            toWorker.prepareToRead(num, start1, size1, start2, size2);
+
+            float* channels[maxChannels] = {};
+
+            for (int channel = 0; channel < maxChannels; ++channel)
+            {
+                channels[channel] = pluginBuffer.getWritePointer(channel);
+                juce::FloatVectorOperations::copy(channels[channel], toWorkerBuffer.getReadPointer(channel, start1), size1);
+
+                if (size2 > 0)
+                    juce::FloatVectorOperations::copy(channels[channel] + size1, toWorkerBuffer.getReadPointer(channel, start2), size2);
+            }
+
+            toWorker.finishedRead(num);
+
+            for (int channel = maxChannels; channel < pluginBuffer.getNumChannels(); ++channel)
+                juce::FloatVectorOperations::clear(pluginBuffer.getWritePointer(channel), num);
+
+            juce::AudioBuffer<float> block(pluginBuffer.getArrayOfWritePointers(), pluginBuffer.getNumChannels(), num);
+            midi.clear();
+            plugin->processBlock(block, midi);
+
+            const int numOutputs = juce::jmax(1, plugin->getTotalNumOutputChannels());
+
+            fromWorker.prepareToWrite(num, start1, size1, start2, size2);
+
+            for (int channel = 0; channel < maxChannels; ++channel)
+            {
+                const float* processed = pluginBuffer.getReadPointer(juce::jmin(channel, numOutputs - 1));
+                juce::FloatVectorOperations::copy(fromWorkerBuffer.getWritePointer(channel, start1), processed, size1);
+
+                if (size2 > 0)
+                    juce::FloatVectorOperations::copy(fromWorkerBuffer.getWritePointer(channel, start2), processed + size1, size2);
+            }
+
+            fromWorker.finishedWrite(num);
+        }
+    }
+}
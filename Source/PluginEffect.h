@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    PluginEffect.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "DeckEffects.h"
+#include "RealtimeSemaphore.h"
+
+namespace OtoDecksAudio
+{
+    // A hosted VST3 or LV2 plugin in a deck's effects rack. The plugin runs with a stereo
+    // layout where it supports one, and its own latency is reported to the rack so the
+    // mixer can line the decks up. The rack's mix doesn't apply; plugins have their own.
+    //
+    // A heavy plugin can run on a worker thread of its own instead of the audio thread.
+    // The audio thread then hands each block over and takes back what the worker made of
+    // the blocks before it, which adds one maximum block of latency.
+    class PluginEffect : public DeckEffect
+    {
+    public:
+        PluginEffect(std::unique_ptr<juce::AudioPluginInstance> pluginToHost, bool processOnWorkerThread);
+        ~PluginEffect() override;
+
+        // Message thread, for parameters and editors
+        juce::AudioPluginInstance& getPlugin() noexcept { return *plugin; }
+
+        bool isProcessingOnWorkerThread() const noexcept { return onWorkerThread; }
+
+        // Blocks the worker didn't finish in time, and which were partly played as silence
+        int getNumUnderruns() const noexcept { return underruns.load(); }
+
+        void reset() noexcept override;
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, const Context& context) noexcept override;
+        double getTailSeconds() const noexcept override { return plugin->getTailLengthSeconds(); }
+        int getLatencySamples() const noexcept override;
+
+    private:
+        class Worker;
+
+        void prepareEffect() override;
+
+        // Runs the plugin over numSamples of up to two channels, no more than a maximum block at a time
+        void processDirect(float* const* channels, int numChannels, int numSamples) noexcept;
+        void processOnWorker(float* const* channels, int numChannels, int numSamples) noexcept;
+        void processPending() noexcept;
+
+        std::unique_ptr<juce::AudioPluginInstance> plugin;
+        const bool onWorkerThread;
+
+        // Sized for every channel the plugin has, so processing never allocates
+        juce::AudioBuffer<float> pluginBuffer;
+        juce::MidiBuffer midi;
+
+        // Worker mode: blocks on their way to the worker and back. The way back starts a
+        // maximum block ahead, which is the latency the worker has to keep up with.
+        juce::AbstractFifo toWorker { 1 };
+        juce::AbstractFifo fromWorker { 1 };
+        juce::AudioBuffer<float> toWorkerBuffer;
+        juce::AudioBuffer<float> fromWorkerBuffer;
+        std::unique_ptr<Worker> worker;
+        std::atomic<int> underruns { 0 };
+
+        // Audio thread. Output still to be skipped because silence was played in its place,
+        // or, below zero, silence still to be played for input that was dropped. Keeps the
+        // latency at exactly one maximum block whatever the worker does.
+        int samplesOwed = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginEffect)
+    };
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    PluginHost.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginHost.h"
+
+namespace OtoDecksAudio
+{
+    class PluginHost::ScanJob : public juce::ThreadPoolJob
+    {
+    public:
+        ScanJob(PluginHost& _owner, bool _rescan)
+            : ThreadPoolJob("PluginHost::ScanJob"),
+              owner(_owner),
+              rescan(_rescan)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            for (auto* format : owner.formatManager.getFormats())
+            {
+                // The known list hands every file to the scanner process, so no dead man's pedal is needed here
+                juce::PluginDirectoryScanner scanner(owner.knownPlugins, *format, format->getDefaultLocationsToSearch(),
+                                                     true, juce::File(), false);
+                juce::String pluginName;
+
+                while (!shouldExit() && scanner.scanNextFile(!rescan, pluginName))
+                {
+                }
+            }
+
+            owner.scanning = false;
+            owner.triggerAsyncUpdate();
+            return jobHasFinished;
+        }
+
+    private:
+        PluginHost& owner;
+        const bool rescan;
+    };
+
+    //==============================================================================
+    PluginHost::PluginHost()
+    {
+        formatManager.addDefaultFormats();
+        knownPlugins.setCustomScanner(std::make_unique<OutOfProcessScanner>());
+
+        if (auto xml = juce::parseXML(getListFile()))
+            knownPlugins.recreateFromXml(*xml);
+    }
+
+    PluginHost::~PluginHost()
+    {
+        cancelPendingUpdate();
+        scanPool.removeAllJobs(true, 4000);
+    }
+
+    juce::File PluginHost::getListFile() const
+    {
+        // Kept next to the track library
+        return juce::File::getCurrentWorkingDirectory().getChildFile("Plugins.xml");
+    }
+
+    void PluginHost::saveList()
+    {
+        if (auto xml = knownPlugins.createXml())
+            xml->writeTo(getListFile());
+    }
+
+    void PluginHost::scanForPlugins(bool rescan)
+    {
+        if (scanning.exchange(true))
+            return;
+
+        scanPool.addJob(new ScanJob(*this, rescan), true);
+    }
+
+    void PluginHost::handleAsyncUpdate()
+    {
+        saveList();
+
+        if (onScanFinished)
+            onScanFinished();
+    }
+
+    void PluginHost::createEffect(const juce::PluginDescription& description, double sampleRate, int blockSize,
+                                  bool processOnWorkerThread, EffectCallback callback)
+    {
+        formatManager.createPluginInstanceAsync(description, sampleRate, blockSize,
+            [processOnWorkerThread, callback = std::move(callback)](std::unique_ptr<juce::AudioPluginInstance> instance,
+                                                                    const juce::String& error)
+            {
+                if (instance == nullptr)
+                {
+                    callback(nullptr, error);
+                    return;
+                }
+
+                callback(std::make_unique<PluginEffect>(std::move(instance), processOnWorkerThread), {});
+            });
+    }
+}
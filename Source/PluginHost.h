@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    PluginHost.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginEffect.h"
+#include "PluginScanner.h"
+
+namespace OtoDecksAudio
+{
+    // Finds and loads effect plugins for the decks' effects racks. Scans run on a
+    // background thread, each plugin in the scanner process, and the list of what was
+    // found is kept between sessions. Everything here is for the message thread.
+    class PluginHost : private juce::AsyncUpdater
+    {
+    public:
+        PluginHost();
+        ~PluginHost() override;
+
+        juce::KnownPluginList& getKnownPlugins() noexcept { return knownPlugins; }
+        juce::AudioPluginFormatManager& getFormatManager() noexcept { return formatManager; }
+
+        // Scans every format's default locations, skipping plugins already on the list
+        // unless rescanning. Does nothing if a scan is already running.
+        void scanForPlugins(bool rescan = false);
+        bool isScanning() const noexcept { return scanning.load(); }
+
+        // Called on the message thread when a scan has finished
+        std::function<void()> onScanFinished;
+
+        // Creates an effect for a deck, prepared by the rack it goes into. The callback gets
+        // nullptr and the reason if the plugin couldn't be loaded.
+        using EffectCallback = std::function<void(std::unique_ptr<PluginEffect>, const juce::String& error)>;
+
+        void createEffect(const juce::PluginDescription& description, double sampleRate, int blockSize,
+                          bool processOnWorkerThread, EffectCallback callback);
+
+    private:
+        class ScanJob;
+
+        juce::File getListFile() const;
+        void saveList();
+        void handleAsyncUpdate() override;
+
+        juce::AudioPluginFormatManager formatManager;
+        juce::KnownPluginList knownPlugins;
+        std::atomic<bool> scanning { false };
+
+        // Declared last so it is destroyed (and its job stopped) before anything the job touches
+        juce::ThreadPool scanPool { 1 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginHost)
+    };
+}
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    PluginScanner.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginScanner.h"
+
+namespace OtoDecksAudio
+{
+    namespace
+    {
+        juce::MemoryBlock toMessage(const juce::XmlElement& xml)
+        {
+            const auto text = xml.toString(juce::XmlElement::TextFormat().singleLine().withoutHeader());
+            return { text.toRawUTF8(), text.getNumBytesAsUTF8() };
+        }
+
+        std::unique_ptr<juce::XmlElement> fromMessage(const juce::MemoryBlock& message)
+        {
+            return juce::parseXML(message.toString());
+        }
+    }
+
+    //==============================================================================
+    // The app's side of the connection. Asks for one plugin file at a time and waits for
+    // the answer on the scan thread.
+    class OutOfProcessScanner::Coordinator : public juce::ChildProcessCoordinator
+    {
+    public:
+        bool launch()
+        {
+            return launchWorkerProcess(juce::File::getSpecialLocation(juce::File::currentExecutableFile), commandLineID, 0, 0);
+        }
+
+        bool isConnected() const noexcept { return !connectionLost.load(); }
+
+        // False if the scanner crashed, hung or went away
+        bool scan(const juce::String& formatName, const juce::String& fileOrIdentifier,
+                  juce::OwnedArray<juce::PluginDescription>& result)
+        {
+            {
+                const juce::ScopedLock sl(replyLock);
+                reply.reset();
+            }
+
+            juce::XmlElement request("SCAN");
+            request.setAttribute("format", formatName);
+            request.setAttribute("identifier", fileOrIdentifier);
+
+            replyArrived.reset();
+
+            if (!sendMessageToWorker(toMessage(request)) || !replyArrived.wait(scanTimeoutMs) || !isConnected())
+                return false;
+
+            const juce::ScopedLock sl(replyLock);
+
+            if (reply == nullptr || !reply->getBoolAttribute("ok"))
+                return false;
+
+            for (auto* child : reply->getChildIterator())
+            {
+                auto description = std::make_unique<juce::PluginDescription>();
+
+                if (description->loadFromXml(*child))
+                    result.add(description.release());
+            }
+
+            return true;
+        }
+
+    private:
+        // Connection thread
+        void handleMessageFromWorker(const juce::MemoryBlock& message) override
+        {
+            {
+                const juce::ScopedLock sl(replyLock);
+                reply = fromMessage(message);
+            }
+
+            replyArrived.signal();
+        }
+
+        void handleConnectionLost() override
+        {
+            connectionLost = true;
+            replyArrived.signal();
+        }
+
+        juce::CriticalSection replyLock;
+        std::unique_ptr<juce::XmlElement> reply;
+        juce::WaitableEvent replyArrived;
+        std::atomic<bool> connectionLost { false };
+    };
+
+    //==============================================================================
+    OutOfProcessScanner::OutOfProcessScanner() = default;
+
+    OutOfProcessScanner::~OutOfProcessScanner() = default;
+
+    bool OutOfProcessScanner::findPluginTypesFor(juce::AudioPluginFormat& format,
+                                                 juce::OwnedArray<juce::PluginDescription>& result,
+                                                 const juce::String& fileOrIdentifier)
+    {
+        const juce::ScopedLock sl(scanLock);
+
+        if (coordinator == nullptr || !coordinator->isConnected())
+        {
+            coordinator = std::make_unique<Coordinator>();
+
+            // Without a scanner process there's nothing to protect the app with, but
+            // blacklisting every plugin would be worse
+            if (!coordinator->launch())
+            {
+                coordinator.reset();
+                format.findAllTypesForFile(result, fileOrIdentifier);
+                return true;
+            }
+        }
+
+        if (coordinator->scan(format.getName(), fileOrIdentifier, result))
+            return true;
+
+        // Kills whatever is left of it; the next plugin starts a fresh one
+        coordinator.reset();
+        return false;
+    }
+
+    //==============================================================================
+    PluginScanWorker::PluginScanWorker()
+    {
+        formatManager.addDefaultFormats();
+    }
+
+    std::unique_ptr<PluginScanWorker> PluginScanWorker::createIfRequested(const juce::String& commandLine)
+    {
+        if (!commandLine.contains(OutOfProcessScanner::commandLineID))
+            return nullptr;
+
+        std::unique_ptr<PluginScanWorker> worker(new PluginScanWorker());
+
+        if (!worker->initialiseFromCommandLine(commandLine, OutOfProcessScanner::commandLineID))
+            return nullptr;
+
+        return worker;
+    }
+
+    void PluginScanWorker::handleMessageFromCoordinator(const juce::MemoryBlock& message)
+    {
+        const auto request = fromMessage(message);
+
+        if (request == nullptr || !request->hasTagName("SCAN"))
+            return;
+
+        const auto formatName = request->getStringAttribute("format");
+        const auto fileOrIdentifier = request->getStringAttribute("identifier");
+
+        // Plenty of plugins expect to be loaded on the message thread
+        juce::MessageManager::callAsync([this, formatName, fileOrIdentifier]
+        {
+            sendMessageToCoordinator(scan(formatName, fileOrIdentifier));
+        });
+    }
+
+    juce::MemoryBlock PluginScanWorker::scan(const juce::String& formatName, const juce::String& fileOrIdentifier)
+    {
+        juce::XmlElement reply("SCANRESULT");
+        reply.setAttribute("ok", false);
+
+        for (auto* format : formatManager.getFormats())
+        {
+            if (format->getName() != formatName)
+                continue;
+
+            juce::OwnedArray<juce::PluginDescription> found;
+            format->findAllTypesForFile(found, fileOrIdentifier);
+
+            for (auto* description : found)
+                reply.addChildElement(description->createXml().release());
+
+            reply.setAttribute("ok", true);
+            break;
+        }
+
+        return toMessage(reply);
+    }
+
+    void PluginScanWorker::handleConnectionLost()
+    {
+        // The app that started this one has gone, so there's nothing left to scan for
+        juce::MessageManager::callAsync([] { juce::JUCEApplicationBase::quit(); });
+    }
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    PluginScanner.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // Scans plugins in a second copy of the app, started with a special command line, so
+    // a plugin that crashes or hangs while it's being scanned only takes that copy down.
+    // The copy is started on the first scan and restarted after a crash; a plugin that
+    // crashed it is reported as failed, which puts it on the known list's blacklist.
+    class OutOfProcessScanner : public juce::KnownPluginList::CustomScanner
+    {
+    public:
+        OutOfProcessScanner();
+        ~OutOfProcessScanner() override;
+
+        // Scan thread
+        bool findPluginTypesFor(juce::AudioPluginFormat& format,
+                                juce::OwnedArray<juce::PluginDescription>& result,
+                                const juce::String& fileOrIdentifier) override;
+
+        // What the scanning copy is started with
+        static constexpr const char* commandLineID = "otodecks-plugin-scanner";
+
+        // How long a single plugin may take before it's given up on
+        static constexpr int scanTimeoutMs = 30000;
+
+    private:
+        class Coordinator;
+
+        juce::CriticalSection scanLock;
+        std::unique_ptr<Coordinator> coordinator;
+    };
+
+    // The scanning copy's side. Main starts one of these instead of the window when the
+    // command line asks for it, and quits once the app that started it goes away.
+    class PluginScanWorker : public juce::ChildProcessWorker
+    {
+    public:
+        // A worker already listening to the app that started this one, or nullptr if this
+        // is an ordinary launch
+        static std::unique_ptr<PluginScanWorker> createIfRequested(const juce::String& commandLine);
+
+        void handleMessageFromCoordinator(const juce::MemoryBlock& message) override;
+        void handleConnectionLost() override;
+
+    private:
+        PluginScanWorker();
+
+        // Message thread
+        juce::MemoryBlock scan(const juce::String& formatName, const juce::String& fileOrIdentifier);
+
+        juce::AudioPluginFormatManager formatManager;
+    };
+}
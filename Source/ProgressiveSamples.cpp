@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    ProgressiveSamples.cpp
+
+  ==============================================================================
+*/
+
+#include "ProgressiveSamples.h"
+#include "Resampler.h"
+
+namespace OtoDecksAudio
+{
+    namespace
+    {
+        juce::int64 getStoredLength(const juce::AudioFormatReader& reader, double sourceStep)
+        {
+            return sourceStep == 1.0 ? reader.lengthInSamples
+                                     : (juce::int64)std::ceil((double)reader.lengthInSamples / sourceStep);
+        }
+    }
+
+    ProgressiveSamples::ProgressiveSamples(std::unique_ptr<juce::AudioFormatReader> readerToUse, SampleStorage::Format format,
+                                           double targetSampleRate, juce::ThreadPool* conversionPool)
+        : reader(std::move(readerToUse)),
+          pool(conversionPool),
+          sampleRate(targetSampleRate > 0.0 ? targetSampleRate : reader->sampleRate),
+          sourceStep(reader->sampleRate / sampleRate),
+          numChunks((int)((getStoredLength(*reader, sourceStep) + chunkSize - 1) / chunkSize)),
+          chunkReady(new std::atomic<bool>[(size_t)juce::jmax(1, numChunks)])
+    {
+        const int numChannels = (int)reader->numChannels;
+
+        // Zeroed storage is mapped lazily by the OS, so this is quick even for long tracks
+        storage.setSize(format, numChannels, getStoredLength(*reader, sourceStep));
+
+        if (sourceStep == 1.0)
+        {
+            chunkBuffer.setSize(numChannels, chunkSize);
+        }
+        else
+        {
+            // Room for the source a chunk covers, plus the filter's reach either side
+            const int margin = Resampler::getSamplesBefore(Resampler::Quality::Sinc, sourceStep)
+                             + Resampler::getSamplesAfter(Resampler::Quality::Sinc, sourceStep) + 2;
+            chunkBuffer.setSize(numChannels, (int)std::ceil(chunkSize * sourceStep) + margin);
+            convertedBuffer.setSize(numChannels, chunkSize);
+        }
+
+        for (int i = 0; i < numChunks; ++i)
+            chunkReady[(size_t)i] = false;
+    }
+
+    ProgressiveSamples::~ProgressiveSamples()
+    {
+        if (thread != nullptr)
+            thread->removeTimeSliceClient(this);
+    }
+
+    void ProgressiveSamples::startDecodingInBackground(juce::TimeSliceThread& decodeThread)
+    {
+        thread = &decodeThread;
+        thread->addTimeSliceClient(this);
+    }
+
+    //==============================================================================
+    bool ProgressiveSamples::read(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        if (!isAvailable(startSample, startSample + numToRead))
+        {
+            juce::FloatVectorOperations::clear(dest, numToRead);
+            return false;
+        }
+
+        return storage.read(channel, startSample, dest, numToRead, gain);
+    }
+
+    bool ProgressiveSamples::addTo(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        if (!isAvailable(startSample, startSample + numToRead))
+            return false;
+
+        return storage.addTo(channel, startSample, dest, numToRead, gain);
+    }
+
+    bool ProgressiveSamples::isAvailable(juce::int64 startSample, juce::int64 endSample) const noexcept
+    {
+        if (endSample <= decodedFrontier.load(std::memory_order_acquire))
+            return true;
+
+        const auto lastChunk = (int)juce::jmin((juce::int64)numChunks - 1, (endSample - 1) / chunkSize);
+
+        for (auto chunk = (int)(juce::jmax((juce::int64)0, startSample) / chunkSize); chunk <= lastChunk; ++chunk)
+            if (!chunkReady[(size_t)chunk].load(std::memory_order_acquire))
+                return false;
+
+        return true;
+    }
+
+    void ProgressiveSamples::setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept
+    {
+        auto& request = requests[(size_t)(playhead % maxPlayheads)];
+        request.position.store(juce::jlimit((juce::int64)0, storage.getNumSamples(), position), std::memory_order_relaxed);
+        request.backwards.store(backwards, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    int ProgressiveSamples::useTimeSlice()
+    {
+        // Once everything is decoded there's nothing left to do but wait to be removed
+        return decodeNextChunk() ? 0 : 500;
+    }
+
+    bool ProgressiveSamples::decodeNextChunk()
+    {
+        const int chunk = pickNextChunk();
+
+        if (chunk < 0)
+        {
+            reader.reset();
+            return false;
+        }
+
+        const auto start = (juce::int64)chunk * chunkSize;
+        const int numToRead = (int)juce::jmin((juce::int64)chunkSize, storage.getNumSamples() - start);
+
+        if (sourceStep == 1.0)
+        {
+            reader->read(&chunkBuffer, 0, numToRead, start, true, true);
+
+            for (int channel = 0; channel < storage.getNumChannels(); ++channel)
+                storage.write(channel, start, chunkBuffer.getReadPointer(channel), numToRead);
+        }
+        else
+        {
+            convertChunk(start, numToRead);
+        }
+
+        chunkReady[(size_t)chunk].store(true, std::memory_order_release);
+
+        while (frontierChunk < numChunks && chunkReady[(size_t)frontierChunk].load(std::memory_order_relaxed))
+            ++frontierChunk;
+
+        decodedFrontier.store(juce::jmin(storage.getNumSamples(), (juce::int64)frontierChunk * chunkSize), std::memory_order_release);
+        return true;
+    }
+
+    void ProgressiveSamples::convertChunk(juce::int64 start, int numToConvert)
+    {
+        constexpr auto quality = Resampler::Quality::Sinc;
+
+        // Read the stretch of source the chunk covers. The reader pads anything before
+        // the start or past the end of the file with silence.
+        const double firstPosition = (double)start * sourceStep;
+        const auto sourceFirst = (juce::int64)std::floor(firstPosition) - Resampler::getSamplesBefore(quality, sourceStep);
+
+        // One extra at the end covers rounding in the resampler's running position
+        const auto sourceLast = (juce::int64)std::floor(firstPosition + sourceStep * (numToConvert - 1))
+                              + Resampler::getSamplesAfter(quality, sourceStep) + 1;
+        const int sourceLength = (int)juce::jmin((juce::int64)chunkBuffer.getNumSamples(), sourceLast + 1 - sourceFirst);
+
+        reader->read(&chunkBuffer, 0, sourceLength, sourceFirst, true, true);
+
+        const auto convertChannel = [this, start, numToConvert, firstPosition, sourceFirst] (int channel)
+        {
+            float* converted = convertedBuffer.getWritePointer(channel);
+
+            Resampler::process(quality, chunkBuffer.getReadPointer(channel), converted, numToConvert,
+                               firstPosition - (double)sourceFirst, sourceStep, 0.0);
+            storage.write(channel, start, converted, numToConvert);
+        };
+
+        const int numChannels = storage.getNumChannels();
+
+        if (pool == nullptr || numChannels == 1)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                convertChannel(channel);
+
+            return;
+        }
+
+        // Every channel but the first goes to the pool, and this thread does the first
+        std::atomic<int> remaining { numChannels - 1 };
+        juce::WaitableEvent allConverted;
+
+        for (int channel = 1; channel < numChannels; ++channel)
+        {
+            pool->addJob([&convertChannel, &remaining, &allConverted, channel]
+            {
+                convertChannel(channel);
+
+                if (--remaining == 0)
+                    allConverted.signal();
+            });
+        }
+
+        convertChannel(0);
+        allConverted.wait();
+    }
+
+    int ProgressiveSamples::pickNextChunk()
+    {
+        if (frontierChunk >= numChunks)
+            return -1;
+
+        // Wherever a playhead is comes first, then carry on from the frontier. Of several
+        // playheads, the one whose next missing chunk is nearest goes first, so each deck
+        // keeps its own place and none of them is starved.
+        int nearestChunk = -1;
+        int nearestDistance = priorityChunks;
+
+        for (auto& request : requests)
+        {
+            const auto position = request.position.load(std::memory_order_relaxed);
+
+            if (position < 0)
+                continue;
+
+            const auto playChunk = (int)(position / chunkSize);
+            const int step = request.backwards.load(std::memory_order_relaxed) ? -1 : 1;
+
+            for (int i = 0; i < nearestDistance; ++i)
+            {
+                const int chunk = playChunk + i * step;
+
+                if (chunk >= 0 && chunk < numChunks && !chunkReady[(size_t)chunk].load(std::memory_order_relaxed))
+                {
+                    nearestChunk = chunk;
+                    nearestDistance = i;
+                    break;
+                }
+            }
+        }
+
+        return nearestChunk >= 0 ? nearestChunk : frontierChunk;
+    }
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    ProgressiveSamples.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleStorage.h"
+
+namespace OtoDecksAudio
+{
+    // A track that is decoded into memory a chunk at a time while it plays. The loader
+    // only decodes the first moments before handing it to the deck; the read-ahead
+    // thread decodes the rest in the background.
+    //
+    // Chunks are decoded in order from the start, except that the chunks under and just
+    // ahead of a playhead always go first, so a seek into audio that isn't decoded yet
+    // only waits for one chunk. Decks sharing the track each have their playhead
+    // followed, and whichever is closest to running out of audio is served first.
+    // Each chunk is published with an atomic flag once it is written and never changes
+    // again, so the audio thread can read it freely.
+    //
+    // Given a target rate, each chunk is converted to it with the sinc resampler as it
+    // is decoded, so the deck never has to convert rates while playing. The channels of
+    // a chunk are converted side by side on the given pool.
+    class ProgressiveSamples : public TrackSamples,
+                               private juce::TimeSliceClient
+    {
+    public:
+        // A target rate of zero keeps the file's own rate
+        ProgressiveSamples(std::unique_ptr<juce::AudioFormatReader> readerToUse, SampleStorage::Format format,
+                           double targetSampleRate = 0.0, juce::ThreadPool* conversionPool = nullptr);
+        ~ProgressiveSamples() override;
+
+        // Decodes one chunk. Returns false once every chunk is done.
+        // Only call this before startDecodingInBackground.
+        bool decodeNextChunk();
+
+        // Hands the rest of the decoding over to the given thread
+        void startDecodingInBackground(juce::TimeSliceThread& decodeThread);
+
+        // The rate the samples are stored at, which is the target rate if one was given
+        double getSampleRate() const noexcept { return sampleRate; }
+
+        // How many samples from the start are decoded without a gap
+        juce::int64 getDecodedFrontier() const noexcept { return decodedFrontier.load(std::memory_order_acquire); }
+
+        int getNumChannels() const noexcept override { return storage.getNumChannels(); }
+        juce::int64 getNumSamples() const noexcept override { return storage.getNumSamples(); }
+
+        bool read(int channel, juce::int64 startSample, float* dest, int numToRead, float gain = 1.0f) const override;
+        bool addTo(int channel, juce::int64 startSample, float* dest, int numToRead, float gain = 1.0f) const override;
+        bool isAvailable(juce::int64 startSample, juce::int64 endSample) const noexcept override;
+        void setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept override;
+        size_t getSizeInBytes() const noexcept override { return storage.getSizeInBytes(); }
+
+    private:
+        int pickNextChunk();
+        void convertChunk(juce::int64 start, int numToConvert);
+        int useTimeSlice() override;
+
+        static constexpr int chunkSize = 1 << 14;
+
+        // Chunks at and ahead of the playhead that are decoded before anything else
+        static constexpr int priorityChunks = 4;
+
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        juce::TimeSliceThread* thread = nullptr;
+        juce::ThreadPool* pool = nullptr;
+
+        const double sampleRate;
+
+        // Source samples per stored sample; exactly one when no conversion is needed
+        const double sourceStep;
+
+        SampleStorage storage;
+        juce::AudioBuffer<float> chunkBuffer;
+        juce::AudioBuffer<float> convertedBuffer;
+
+        const int numChunks;
+        std::unique_ptr<std::atomic<bool>[]> chunkReady;
+        std::atomic<juce::int64> decodedFrontier { 0 };
+        int frontierChunk = 0;
+
+        // Where each playhead says playback is heading, or -1 for none yet. More playheads
+        // than this share slots, and then pull the priority chunks between them.
+        static constexpr int maxPlayheads = 4;
+
+        struct Request
+        {
+            std::atomic<juce::int64> position { -1 };
+            std::atomic<bool> backwards { false };
+        };
+
+        std::array<Request, maxPlayheads> requests;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProgressiveSamples)
+    };
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    RealtimeSemaphore.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSemaphore.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+namespace OtoDecksAudio
+{
+   #if JUCE_WINDOWS
+    struct RealtimeSemaphore::Native
+    {
+        Native() : handle(CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr)) {}
+        ~Native() { CloseHandle(handle); }
+
+        void post() noexcept { ReleaseSemaphore(handle, 1, nullptr); }
+        void wait() noexcept { WaitForSingleObject(handle, INFINITE); }
+
+        HANDLE handle;
+    };
+   #elif JUCE_MAC || JUCE_IOS
+    // Unnamed POSIX semaphores aren't implemented on Apple's platforms
+    struct RealtimeSemaphore::Native
+    {
+        Native() : handle(dispatch_semaphore_create(0)) {}
+        ~Native() { dispatch_release(handle); }
+
+        void post() noexcept { dispatch_semaphore_signal(handle); }
+        void wait() noexcept { dispatch_semaphore_wait(handle, DISPATCH_TIME_FOREVER); }
+
+        dispatch_semaphore_t handle;
+    };
+   #else
+    struct RealtimeSemaphore::Native
+    {
+        Native() { sem_init(&handle, 0, 0); }
+        ~Native() { sem_destroy(&handle); }
+
+        void post() noexcept { sem_post(&handle); }
+
+        void wait() noexcept
+        {
+            while (sem_wait(&handle) != 0 && errno == EINTR)
+            {
+            }
+        }
+
+        sem_t handle;
+    };
+   #endif
+
+    //==============================================================================
+    RealtimeSemaphore::RealtimeSemaphore()
+        : native(std::make_unique<Native>())
+    {
+    }
+
+    RealtimeSemaphore::~RealtimeSemaphore() = default;
+
+    void RealtimeSemaphore::post() noexcept
+    {
+        native->post();
+    }
+
+    void RealtimeSemaphore::sleep() noexcept
+    {
+        native->wait();
+    }
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    RealtimeSemaphore.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // Wakes a worker thread from the audio thread. Signalling is an atomic add, and only
+    // calls into the OS when the worker is actually asleep, with a semaphore post that
+    // takes no lock; juce::WaitableEvent locks a mutex on every signal instead.
+    //
+    // Signals count up, so a worker that was busy when signalled goes straight round again.
+    class RealtimeSemaphore
+    {
+    public:
+        RealtimeSemaphore();
+        ~RealtimeSemaphore();
+
+        // Any thread
+        void signal() noexcept
+        {
+            if (count.fetch_add(1, std::memory_order_release) < 0)
+                post();
+        }
+
+        // The waiting thread. Returns once there's a signal to take.
+        void wait() noexcept
+        {
+            if (count.fetch_sub(1, std::memory_order_acquire) < 1)
+                sleep();
+        }
+
+    private:
+        struct Native;
+
+        void post() noexcept;
+        void sleep() noexcept;
+
+        // Signals not yet taken, or minus the number of threads asleep
+        std::atomic<int> count { 0 };
+        std::unique_ptr<Native> native;
+
+        JUCE_DECLARE_NON_COPYABLE (RealtimeSemaphore)
+    };
+}
@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    Resampler.cpp
+
+  ==============================================================================
+*/
+
+#include "Resampler.h"
+#include "SimdHelpers.h"
+
+namespace OtoDecksAudio
+{
+    namespace
+    {
+        constexpr int numPhases = 256;
+        constexpr int baseTaps = 16;
+
+        // Each band is used for increments up to its ratio. Faster playback needs a lower
+        // cutoff to keep what it skips over from aliasing, and a longer filter to get it.
+        constexpr double bandRatios[] = { 1.0, 1.5, 2.0, 3.0, 4.0 };
+        constexpr int numBands = (int)(sizeof(bandRatios) / sizeof(bandRatios[0]));
+
+        double besselI0(double x)
+        {
+            double sum = 1.0, term = 1.0;
+
+            for (int k = 1; k < 32; ++k)
+            {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        struct SincBand
+        {
+            SincBand() = default;
+
+            explicit SincBand(double ratio)
+                : numTaps(baseTaps * (int)std::ceil(ratio * 4.0) / 4)
+            {
+                constexpr double beta = 8.0;
+                const double cutoff = 0.46 / ratio;
+                const int half = numTaps / 2;
+
+                coefficients.resize((size_t)((numPhases + 1) * numTaps));
+
+                // One extra phase at the end so every phase has a neighbour to blend towards
+                for (int phase = 0; phase <= numPhases; ++phase)
+                {
+                    float* row = coefficients.data() + phase * numTaps;
+                    const double frac = (double)phase / numPhases;
+                    double sum = 0.0;
+
+                    for (int k = 0; k < numTaps; ++k)
+                    {
+                        const double distance = k - half + 1 - frac;
+                        const double x = distance / half;
+                        const double window = std::abs(x) <= 1.0 ? besselI0(beta * std::sqrt(1.0 - x * x)) / besselI0(beta) : 0.0;
+                        const double arg = juce::MathConstants<double>::pi * 2.0 * cutoff * distance;
+                        const double sinc = distance == 0.0 ? 1.0 : std::sin(arg) / arg;
+
+                        row[k] = (float)(2.0 * cutoff * sinc * window);
+                        sum += row[k];
+                    }
+
+                    // Unity gain at DC for every phase
+                    for (int k = 0; k < numTaps; ++k)
+                        row[k] = (float)(row[k] / sum);
+                }
+            }
+
+            const float* getPhase(int phase) const noexcept { return coefficients.data() + phase * numTaps; }
+
+            int numTaps = baseTaps;
+            std::vector<float> coefficients;
+        };
+
+        struct SincTables
+        {
+            SincTables()
+            {
+                for (int i = 0; i < numBands; ++i)
+                    bands[i] = SincBand(bandRatios[i]);
+            }
+
+            SincBand bands[numBands];
+        };
+
+        const SincTables& getSincTables()
+        {
+            static const SincTables tables;
+            return tables;
+        }
+
+        const SincBand& getBandFor(double maxIncrement) noexcept
+        {
+            const auto& tables = getSincTables();
+
+            for (int i = 0; i < numBands - 1; ++i)
+                if (std::abs(maxIncrement) <= bandRatios[i])
+                    return tables.bands[i];
+
+            return tables.bands[numBands - 1];
+        }
+
+        // Dot product of the source with coefficients blended between two neighbouring phases
+        inline float convolve(const float* phase0, const float* phase1, float blend, const float* source, int numTaps) noexcept
+        {
+           #if OTODECKS_USE_SSE2
+            const __m128 blendV = _mm_set1_ps(blend);
+            __m128 acc = _mm_setzero_ps();
+
+            for (int k = 0; k < numTaps; k += 4)
+            {
+                const __m128 c0 = _mm_loadu_ps(phase0 + k);
+                const __m128 c = _mm_add_ps(c0, _mm_mul_ps(blendV, _mm_sub_ps(_mm_loadu_ps(phase1 + k), c0)));
+                acc = _mm_add_ps(acc, _mm_mul_ps(c, _mm_loadu_ps(source + k)));
+            }
+
+            acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+            acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+            return _mm_cvtss_f32(acc);
+           #elif OTODECKS_USE_NEON
+            float32x4_t acc = vdupq_n_f32(0.0f);
+
+            for (int k = 0; k < numTaps; k += 4)
+            {
+                const float32x4_t c0 = vld1q_f32(phase0 + k);
+                const float32x4_t c = vmlaq_n_f32(c0, vsubq_f32(vld1q_f32(phase1 + k), c0), blend);
+                acc = vmlaq_f32(acc, c, vld1q_f32(source + k));
+            }
+
+            return vaddvq_f32(acc);
+           #else
+            float acc = 0.0f;
+
+            for (int k = 0; k < numTaps; ++k)
+                acc += (phase0[k] + blend * (phase1[k] - phase0[k])) * source[k];
+
+            return acc;
+           #endif
+        }
+    }
+
+    //==============================================================================
+    void Resampler::prepare()
+    {
+        getSincTables();
+    }
+
+    int Resampler::getSamplesBefore(Quality quality, double maxIncrement) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::Linear: return 0;
+            case Quality::Cubic:  return 1;
+            case Quality::Sinc:   return getBandFor(maxIncrement).numTaps / 2 - 1;
+        }
+
+        return 0;
+    }
+
+    int Resampler::getSamplesAfter(Quality quality, double maxIncrement) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::Linear: return 1;
+            case Quality::Cubic:  return 2;
+            case Quality::Sinc:   return getBandFor(maxIncrement).numTaps / 2;
+        }
+
+        return 1;
+    }
+
+    void Resampler::process(Quality quality, const float* source, float* dest, int numSamples,
+                            double position, double increment, double incrementStep) noexcept
+    {
+        switch (quality)
+        {
+            case Quality::Linear:
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const double index = std::floor(position);
+                    const auto frac = (float)(position - index);
+                    const float* s = source + (int)index;
+
+                    dest[i] = s[0] + frac * (s[1] - s[0]);
+
+                    position += increment;
+                    increment += incrementStep;
+                }
+                break;
+            }
+
+            case Quality::Cubic:
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const double index = std::floor(position);
+                    const auto frac = (float)(position - index);
+                    const float* s = source + (int)index;
+
+                    // Catmull-Rom through the two samples either side
+                    const float c1 = 0.5f * (s[1] - s[-1]);
+                    const float c2 = s[-1] - 2.5f * s[0] + 2.0f * s[1] - 0.5f * s[2];
+                    const float c3 = 0.5f * (s[2] - s[-1]) + 1.5f * (s[0] - s[1]);
+
+                    dest[i] = ((c3 * frac + c2) * frac + c1) * frac + s[0];
+
+                    position += increment;
+                    increment += incrementStep;
+                }
+                break;
+            }
+
+            case Quality::Sinc:
+            {
+                const double endIncrement = increment + incrementStep * numSamples;
+                const auto& band = getBandFor(juce::jmax(std::abs(increment), std::abs(endIncrement)));
+                const int firstTap = 1 - band.numTaps / 2;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const double index = std::floor(position);
+                    const double phase = (position - index) * numPhases;
+                    const int phaseIndex = (int)phase;
+
+                    dest[i] = convolve(band.getPhase(phaseIndex), band.getPhase(phaseIndex + 1), (float)(phase - phaseIndex),
+                                       source + (int)index + firstTap, band.numTaps);
+
+                    position += increment;
+                    increment += incrementStep;
+                }
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    Resampler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // Reads a run of source samples at a fractional, gliding position, at one of
+    // several quality levels. Sources are plain float arrays that must hold the
+    // samples getSamplesBefore/After say each read position needs around it.
+    class Resampler
+    {
+    public:
+        enum class Quality
+        {
+            Linear,     // 2 points: cheapest, dull highs and audible aliasing
+            Cubic,      // 4-point Hermite: much cleaner for a few more multiplies
+            Sinc        // Polyphase windowed sinc, band-limited for the speed being played
+        };
+
+        // Builds the shared sinc tables. Call from a non-real-time thread before processing.
+        static void prepare();
+
+        // Source samples needed either side of the integer part of a read position,
+        // for any increment up to the given one
+        static int getSamplesBefore(Quality quality, double maxIncrement) noexcept;
+        static int getSamplesAfter(Quality quality, double maxIncrement) noexcept;
+
+        // Writes numSamples outputs read from source, starting at position and moving by
+        // increment, which itself changes by incrementStep after every output. Every read
+        // position must have its margins inside the source array.
+        static void process(Quality quality, const float* source, float* dest, int numSamples,
+                            double position, double increment, double incrementStep) noexcept;
+    };
+}
@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    SampleStorage.cpp
+
+  ==============================================================================
+*/
+
+#include "SampleStorage.h"
+#include "SimdHelpers.h"
+
+namespace OtoDecksAudio
+{
+    namespace
+    {
+        constexpr float int16ToFloatScale = 1.0f / 32767.0f;
+
+        template <typename Dest, typename Source>
+        inline Dest bitCast(Source value) noexcept
+        {
+            static_assert(sizeof(Dest) == sizeof(Source), "bitCast needs types of equal size");
+            Dest result;
+            std::memcpy(&result, &value, sizeof(Dest));
+            return result;
+        }
+
+        // Half to float without F16C: move exponent and mantissa into place and rebias the
+        // exponent. Half denormals are built as normals and corrected with a subtraction, so
+        // no float denormals are involved and flush-to-zero modes don't change the result.
+        inline float halfToFloat(juce::uint16 h) noexcept
+        {
+            const juce::uint32 sign = (juce::uint32)(h & 0x8000u) << 16;
+            juce::uint32 bits = (juce::uint32)(h & 0x7fffu) << 13;
+            const juce::uint32 exponent = bits & 0x0f800000u;
+
+            bits += 0x38000000u;
+
+            if (exponent == 0x0f800000u)
+            {
+                bits += 0x38000000u;    // Inf and NaN
+            }
+            else if (exponent == 0)
+            {
+                bits += 0x00800000u;
+                bits = bitCast<juce::uint32>(bitCast<float>(bits) - 0x1.0p-14f);
+            }
+
+            return bitCast<float>(bits | sign);
+        }
+
+        // Float to half with round-to-nearest-even
+        inline juce::uint16 floatToHalf(float f) noexcept
+        {
+            juce::uint32 bits = bitCast<juce::uint32>(f);
+            const auto sign = (juce::uint16)((bits >> 16) & 0x8000u);
+            bits &= 0x7fffffffu;
+
+            if (bits >= 0x7f800000u)
+                return (juce::uint16)(sign | 0x7c00u | (bits > 0x7f800000u ? 0x0200u : 0u));
+
+            // Too big for a half: round to infinity
+            if (bits >= 0x477ff000u)
+                return (juce::uint16)(sign | 0x7c00u);
+
+            // Below the smallest normal half: let float arithmetic do the denormal rounding
+            if (bits < 0x38800000u)
+                return (juce::uint16)(sign | (juce::uint16)std::lrint(bitCast<float>(bits) * 16777216.0f));
+
+            const juce::uint32 mantissaOdd = (bits >> 13) & 1u;
+            bits += 0xc8000fffu + mantissaOdd;
+            return (juce::uint16)(sign | (bits >> 13));
+        }
+
+       #if OTODECKS_USE_SSE2
+        inline __m128 halfToFloat(__m128i h) noexcept
+        {
+            const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+            const __m128i magnitude = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+            const __m128i exponent = _mm_and_si128(magnitude, _mm_set1_epi32(0x0f800000));
+            const __m128i infOrNaN = _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x0f800000));
+            const __m128i denormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+
+            __m128i bits = _mm_add_epi32(magnitude, _mm_set1_epi32(0x38000000));
+            bits = _mm_add_epi32(bits, _mm_and_si128(infOrNaN, _mm_set1_epi32(0x38000000)));
+            bits = _mm_add_epi32(bits, _mm_and_si128(denormal, _mm_set1_epi32(0x00800000)));
+
+            __m128 result = _mm_sub_ps(_mm_castsi128_ps(bits), _mm_and_ps(_mm_castsi128_ps(denormal), _mm_set1_ps(0x1.0p-14f)));
+            return _mm_or_ps(result, _mm_castsi128_ps(sign));
+        }
+       #endif
+
+        template <bool accumulate>
+        inline void storeOrAdd(float* dest, float value) noexcept
+        {
+            if constexpr (accumulate)
+                *dest += value;
+            else
+                *dest = value;
+        }
+
+        template <bool accumulate>
+        void convertInt16(float* dest, const juce::int16* source, int num, float gain) noexcept
+        {
+            const float scale = gain * int16ToFloatScale;
+            int i = 0;
+
+           #if OTODECKS_USE_SSE2
+            const __m128 scaleV = _mm_set1_ps(scale);
+
+            for (; i + 8 <= num; i += 8)
+            {
+                const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+                // Duplicating each sample into both halves of a 32-bit lane then shifting right sign-extends it
+                __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)), scaleV);
+                __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)), scaleV);
+
+                if constexpr (accumulate)
+                {
+                    lo = _mm_add_ps(lo, _mm_loadu_ps(dest + i));
+                    hi = _mm_add_ps(hi, _mm_loadu_ps(dest + i + 4));
+                }
+
+                _mm_storeu_ps(dest + i, lo);
+                _mm_storeu_ps(dest + i + 4, hi);
+            }
+           #elif OTODECKS_USE_NEON
+            for (; i + 8 <= num; i += 8)
+            {
+                const int16x8_t s = vld1q_s16(source + i);
+                float32x4_t lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), scale);
+                float32x4_t hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), scale);
+
+                if constexpr (accumulate)
+                {
+                    lo = vaddq_f32(lo, vld1q_f32(dest + i));
+                    hi = vaddq_f32(hi, vld1q_f32(dest + i + 4));
+                }
+
+                vst1q_f32(dest + i, lo);
+                vst1q_f32(dest + i + 4, hi);
+            }
+           #endif
+
+            for (; i < num; ++i)
+                storeOrAdd<accumulate>(dest + i, (float)source[i] * scale);
+        }
+
+        template <bool accumulate>
+        void convertFloat16(float* dest, const juce::uint16* source, int num, float gain) noexcept
+        {
+            int i = 0;
+
+           #if OTODECKS_USE_SSE2
+            const __m128 gainV = _mm_set1_ps(gain);
+            const __m128i zero = _mm_setzero_si128();
+
+            for (; i + 8 <= num; i += 8)
+            {
+                const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                __m128 lo = _mm_mul_ps(halfToFloat(_mm_unpacklo_epi16(h, zero)), gainV);
+                __m128 hi = _mm_mul_ps(halfToFloat(_mm_unpackhi_epi16(h, zero)), gainV);
+
+                if constexpr (accumulate)
+                {
+                    lo = _mm_add_ps(lo, _mm_loadu_ps(dest + i));
+                    hi = _mm_add_ps(hi, _mm_loadu_ps(dest + i + 4));
+                }
+
+                _mm_storeu_ps(dest + i, lo);
+                _mm_storeu_ps(dest + i + 4, hi);
+            }
+           #elif OTODECKS_USE_NEON
+            for (; i + 4 <= num; i += 4)
+            {
+                float32x4_t v = vmulq_n_f32(vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + i))), gain);
+
+                if constexpr (accumulate)
+                    v = vaddq_f32(v, vld1q_f32(dest + i));
+
+                vst1q_f32(dest + i, v);
+            }
+           #endif
+
+            for (; i < num; ++i)
+                storeOrAdd<accumulate>(dest + i, halfToFloat(source[i]) * gain);
+        }
+    }
+
+    //==============================================================================
+    void SampleStorage::setSize(Format newFormat, int newNumChannels, juce::int64 newNumSamples)
+    {
+        format = newFormat;
+        numChannels = newNumChannels;
+        numSamples = newNumSamples;
+
+        channelData.clear();
+        channelData.resize((size_t)numChannels);
+
+        for (auto& data : channelData)
+            data.allocate((size_t)numSamples * getBytesPerSample(format), true);
+    }
+
+    void SampleStorage::write(int channel, juce::int64 destStartSample, const float* source, int num)
+    {
+        jassert(channel < numChannels && destStartSample + num <= numSamples);
+
+        switch (format)
+        {
+            case Format::Float32:
+            {
+                auto* dest = reinterpret_cast<float*>(channelData[(size_t)channel].get()) + destStartSample;
+                juce::FloatVectorOperations::copy(dest, source, num);
+                break;
+            }
+            case Format::Int16:
+            {
+                auto* dest = reinterpret_cast<juce::int16*>(channelData[(size_t)channel].get()) + destStartSample;
+                for (int i = 0; i < num; ++i)
+                    dest[i] = (juce::int16)juce::roundToInt(juce::jlimit(-1.0f, 1.0f, source[i]) * 32767.0f);
+                break;
+            }
+            case Format::Float16:
+            {
+                auto* dest = reinterpret_cast<juce::uint16*>(channelData[(size_t)channel].get()) + destStartSample;
+                for (int i = 0; i < num; ++i)
+                    dest[i] = floatToHalf(source[i]);
+                break;
+            }
+        }
+    }
+
+    bool SampleStorage::read(int channel, juce::int64 startSample, float* dest, int num, float gain) const
+    {
+        convert<false>(channel, startSample, dest, num, gain);
+        return true;
+    }
+
+    bool SampleStorage::addTo(int channel, juce::int64 startSample, float* dest, int num, float gain) const
+    {
+        convert<true>(channel, startSample, dest, num, gain);
+        return true;
+    }
+
+    template <bool accumulate>
+    void SampleStorage::convert(int channel, juce::int64 startSample, float* dest, int num, float gain) const
+    {
+        jassert(channel < numChannels && startSample >= 0 && startSample + num <= numSamples);
+
+        const char* data = channelData[(size_t)channel].get();
+
+        switch (format)
+        {
+            case Format::Float32:
+            {
+                auto* source = reinterpret_cast<const float*>(data) + startSample;
+
+                if constexpr (accumulate)
+                    juce::FloatVectorOperations::addWithMultiply(dest, source, gain, num);
+                else if (gain == 1.0f)
+                    juce::FloatVectorOperations::copy(dest, source, num);
+                else
+                    juce::FloatVectorOperations::copyWithMultiply(dest, source, gain, num);
+                break;
+            }
+            case Format::Int16:
+                convertInt16<accumulate>(dest, reinterpret_cast<const juce::int16*>(data) + startSample, num, gain);
+                break;
+            case Format::Float16:
+                convertFloat16<accumulate>(dest, reinterpret_cast<const juce::uint16*>(data) + startSample, num, gain);
+                break;
+        }
+    }
+
+    size_t SampleStorage::getBytesPerSample(Format formatToUse) noexcept
+    {
+        return formatToUse == Format::Float32 ? sizeof(float) : sizeof(juce::uint16);
+    }
+
+    size_t SampleStorage::getSizeInBytes() const noexcept
+    {
+        return (size_t)numChannels * (size_t)numSamples * getBytesPerSample(format);
+    }
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    SampleStorage.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TrackSamples.h"
+
+namespace OtoDecksAudio
+{
+    // Decoded audio held in memory in one of several sample formats. The compact
+    // formats take half the memory of float and are converted back to float with
+    // vectorised kernels as they are read, so playback code only ever sees floats.
+    class SampleStorage : public TrackSamples
+    {
+    public:
+        enum class Format
+        {
+            Float32,    // 4 bytes per sample, bit-exact
+            Int16,      // 2 bytes per sample, 16-bit PCM
+            Float16     // 2 bytes per sample, half-float: more headroom than Int16, same size
+        };
+
+        SampleStorage() = default;
+
+        // Allocates zeroed storage, discarding anything held before
+        void setSize(Format newFormat, int newNumChannels, juce::int64 newNumSamples);
+
+        // Converts float samples into storage. Meant for background threads.
+        void write(int channel, juce::int64 destStartSample, const float* source, int numSamples);
+
+        // Converts stored samples to float, scaled by gain. Real-time safe; always succeeds.
+        bool read(int channel, juce::int64 startSample, float* dest, int numSamples, float gain = 1.0f) const override;
+
+        // Like read, but adds into dest instead of overwriting it
+        bool addTo(int channel, juce::int64 startSample, float* dest, int numSamples, float gain = 1.0f) const override;
+
+        Format getFormat() const noexcept { return format; }
+        int getNumChannels() const noexcept override { return numChannels; }
+        juce::int64 getNumSamples() const noexcept override { return numSamples; }
+
+        static size_t getBytesPerSample(Format formatToUse) noexcept;
+        size_t getSizeInBytes() const noexcept override;
+
+    private:
+        template <bool accumulate>
+        void convert(int channel, juce::int64 startSample, float* dest, int num, float gain) const;
+
+        Format format = Format::Float32;
+        int numChannels = 0;
+        juce::int64 numSamples = 0;
+        std::vector<juce::HeapBlock<char>> channelData;
+
+        JUCE_DECLARE_NON_COPYABLE (SampleStorage)
+    };
+}
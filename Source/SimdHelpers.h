@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    SimdHelpers.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// SSE2 on 64-bit Intel, NEON on 64-bit ARM, and plain loops everywhere else. Kernels
+// that need more than the Quad operations below test these directly.
+#if JUCE_INTEL && JUCE_64BIT
+ #define OTODECKS_USE_SSE2 1
+ #include <emmintrin.h>
+#elif JUCE_ARM && JUCE_64BIT
+ #define OTODECKS_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+namespace OtoDecksAudio
+{
+    // Four float lanes, on whichever vectors there are
+    namespace Simd
+    {
+       #if OTODECKS_USE_SSE2
+        using Quad = __m128;
+
+        inline Quad loadQuad(const float* p) noexcept          { return _mm_load_ps(p); }
+        inline Quad loadUnaligned(const float* p) noexcept     { return _mm_loadu_ps(p); }
+        inline void storeQuad(float* p, Quad v) noexcept       { _mm_store_ps(p, v); }
+        inline Quad makeQuad(float a, float b, float c, float d) noexcept { return _mm_setr_ps(a, b, c, d); }
+        inline Quad splat(float v) noexcept                    { return _mm_set1_ps(v); }
+        inline Quad add(Quad a, Quad b) noexcept               { return _mm_add_ps(a, b); }
+        inline Quad sub(Quad a, Quad b) noexcept               { return _mm_sub_ps(a, b); }
+        inline Quad mul(Quad a, Quad b) noexcept               { return _mm_mul_ps(a, b); }
+        inline Quad max(Quad a, Quad b) noexcept               { return _mm_max_ps(a, b); }
+        inline Quad abs(Quad v) noexcept                       { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+        inline Quad upperPair(Quad v) noexcept                 { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 2, 3, 2)); }
+        inline Quad swapPairs(Quad v) noexcept                 { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)); }
+
+        // (a, b, the two low lanes of c)
+        inline Quad pairWithLow(float a, float b, Quad c) noexcept
+        {
+            return _mm_movelh_ps(_mm_unpacklo_ps(_mm_set_ss(a), _mm_set_ss(b)), c);
+        }
+       #elif OTODECKS_USE_NEON
+        using Quad = float32x4_t;
+
+        inline Quad loadQuad(const float* p) noexcept          { return vld1q_f32(p); }
+        inline Quad loadUnaligned(const float* p) noexcept     { return vld1q_f32(p); }
+        inline void storeQuad(float* p, Quad v) noexcept       { vst1q_f32(p, v); }
+        inline Quad makeQuad(float a, float b, float c, float d) noexcept { const float v[4] = { a, b, c, d }; return vld1q_f32(v); }
+        inline Quad splat(float v) noexcept                    { return vdupq_n_f32(v); }
+        inline Quad add(Quad a, Quad b) noexcept               { return vaddq_f32(a, b); }
+        inline Quad sub(Quad a, Quad b) noexcept               { return vsubq_f32(a, b); }
+        inline Quad mul(Quad a, Quad b) noexcept               { return vmulq_f32(a, b); }
+        inline Quad max(Quad a, Quad b) noexcept               { return vmaxq_f32(a, b); }
+        inline Quad abs(Quad v) noexcept                       { return vabsq_f32(v); }
+        inline Quad upperPair(Quad v) noexcept                 { return vcombine_f32(vget_high_f32(v), vget_high_f32(v)); }
+        inline Quad swapPairs(Quad v) noexcept                 { return vcombine_f32(vget_high_f32(v), vget_low_f32(v)); }
+
+        inline Quad pairWithLow(float a, float b, Quad c) noexcept
+        {
+            const float pair[2] = { a, b };
+            return vcombine_f32(vld1_f32(pair), vget_low_f32(c));
+        }
+       #else
+        struct Quad { float v[4]; };
+
+        inline Quad loadQuad(const float* p) noexcept          { return { { p[0], p[1], p[2], p[3] } }; }
+        inline Quad loadUnaligned(const float* p) noexcept     { return loadQuad(p); }
+        inline void storeQuad(float* p, Quad q) noexcept       { for (int i = 0; i < 4; ++i) p[i] = q.v[i]; }
+        inline Quad makeQuad(float a, float b, float c, float d) noexcept { return { { a, b, c, d } }; }
+        inline Quad splat(float v) noexcept                    { return { { v, v, v, v } }; }
+        inline Quad add(Quad a, Quad b) noexcept               { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+        inline Quad sub(Quad a, Quad b) noexcept               { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+        inline Quad mul(Quad a, Quad b) noexcept               { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+        inline Quad max(Quad a, Quad b) noexcept               { return { { juce::jmax(a.v[0], b.v[0]), juce::jmax(a.v[1], b.v[1]), juce::jmax(a.v[2], b.v[2]), juce::jmax(a.v[3], b.v[3]) } }; }
+        inline Quad abs(Quad q) noexcept                       { return { { std::abs(q.v[0]), std::abs(q.v[1]), std::abs(q.v[2]), std::abs(q.v[3]) } }; }
+        inline Quad upperPair(Quad q) noexcept                 { return { { q.v[2], q.v[3], q.v[2], q.v[3] } }; }
+        inline Quad swapPairs(Quad q) noexcept                 { return { { q.v[2], q.v[3], q.v[0], q.v[1] } }; }
+        inline Quad pairWithLow(float a, float b, Quad c) noexcept { return { { a, b, c.v[0], c.v[1] } }; }
+       #endif
+
+        inline float highestLane(Quad v) noexcept
+        {
+            alignas(16) float lanes[4];
+            storeQuad(lanes, v);
+            return juce::jmax(lanes[0], lanes[1], lanes[2], lanes[3]);
+        }
+
+        inline float sumOfLanes(Quad v) noexcept
+        {
+            alignas(16) float lanes[4];
+            storeQuad(lanes, v);
+            return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+    }
+}
@@ -0,0 +1,295 @@
+/*
+  ==============================================================================
+
+    StreamingSamples.cpp
+
+  ==============================================================================
+*/
+
+#include "StreamingSamples.h"
+
+namespace OtoDecksAudio
+{
+    StreamingSamples::StreamingSamples(std::unique_ptr<juce::AudioFormatReader> readerToUse,
+                                       double lookAheadSeconds,
+                                       juce::TimeSliceThread& readAheadThread)
+        : reader(std::move(readerToUse)),
+          thread(readAheadThread),
+          numChannels((int)reader->numChannels),
+          numSamples(reader->lengthInSamples),
+          lookAhead((juce::int64)(juce::jlimit(1.0, 300.0, lookAheadSeconds) * reader->sampleRate) + chunkSize),
+          capacity(lookAhead * 2),
+          pinLength((int)(pinnedSeconds * reader->sampleRate) + pinnedBefore)
+    {
+        ring.setSize(numChannels, (int)capacity);
+        pinned.setSize(numChannels, pinLength * maxPinnedRegions);
+
+        while (fillNextChunk())
+        {
+        }
+
+        thread.addTimeSliceClient(this);
+    }
+
+    StreamingSamples::~StreamingSamples()
+    {
+        thread.removeTimeSliceClient(this);
+    }
+
+    //==============================================================================
+    bool StreamingSamples::read(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        if (readFromRing(channel, startSample, dest, numToRead, gain)
+             || readFromPins(channel, startSample, dest, numToRead, gain))
+            return true;
+
+        juce::FloatVectorOperations::clear(dest, numToRead);
+        return false;
+    }
+
+    bool StreamingSamples::readFromRing(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        const auto startEpoch = epoch.load(std::memory_order_acquire);
+
+        if (!isInRing(startSample, startSample + numToRead))
+            return false;
+
+        const int ringIndex = (int)(startSample % capacity);
+        const int firstPart = juce::jmin(numToRead, (int)capacity - ringIndex);
+
+        juce::FloatVectorOperations::copyWithMultiply(dest, ring.getReadPointer(channel, ringIndex), gain, firstPart);
+
+        if (firstPart < numToRead)
+            juce::FloatVectorOperations::copyWithMultiply(dest + firstPart, ring.getReadPointer(channel), gain, numToRead - firstPart);
+
+        // If the run is still inside the range, nothing overwrote it while it was being copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        return epoch.load(std::memory_order_acquire) == startEpoch && isInRing(startSample, startSample + numToRead);
+    }
+
+    bool StreamingSamples::readFromPins(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        for (size_t slot = 0; slot < pins.size(); ++slot)
+        {
+            const auto& pin = pins[slot];
+            const auto startGeneration = pin.generation.load(std::memory_order_acquire);
+            const auto pinStart = pin.validStart.load(std::memory_order_acquire);
+
+            if (startSample < pinStart || startSample + numToRead > pin.validEnd.load(std::memory_order_acquire))
+                continue;
+
+            juce::FloatVectorOperations::copyWithMultiply(dest, pinned.getReadPointer(channel, (int)slot * pinLength + (int)(startSample - pinStart)),
+                                                          gain, numToRead);
+
+            // Same check as the ring: a slot that moved on while copying may have been overwritten
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (pin.generation.load(std::memory_order_acquire) == startGeneration)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool StreamingSamples::addTo(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const
+    {
+        // A torn copy can't be taken back out of dest, so check each piece before adding it
+        constexpr int pieceSize = 256;
+        float piece[pieceSize];
+        bool complete = true;
+
+        for (int offset = 0; offset < numToRead; offset += pieceSize)
+        {
+            const int num = juce::jmin(pieceSize, numToRead - offset);
+
+            if (read(channel, startSample + offset, piece, num, gain))
+                juce::FloatVectorOperations::add(dest + offset, piece, num);
+            else
+                complete = false;
+        }
+
+        return complete;
+    }
+
+    bool StreamingSamples::isAvailable(juce::int64 startSample, juce::int64 endSample) const noexcept
+    {
+        if (isInRing(startSample, endSample))
+            return true;
+
+        for (const auto& pin : pins)
+            if (startSample >= pin.validStart.load(std::memory_order_acquire)
+                 && endSample <= pin.validEnd.load(std::memory_order_acquire))
+                return true;
+
+        return false;
+    }
+
+    bool StreamingSamples::isInRing(juce::int64 startSample, juce::int64 endSample) const noexcept
+    {
+        return startSample >= validStart.load(std::memory_order_acquire)
+            && endSample <= validEnd.load(std::memory_order_acquire);
+    }
+
+    void StreamingSamples::setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept
+    {
+        juce::ignoreUnused(playhead);
+
+        requestedPosition.store(position, std::memory_order_relaxed);
+        requestedBackwards.store(backwards, std::memory_order_relaxed);
+    }
+
+    void StreamingSamples::pinRegion(int slot, juce::int64 startSample)
+    {
+        if (juce::isPositiveAndBelow(slot, maxPinnedRegions))
+            pins[(size_t)slot].requested.store(startSample < 0 ? -1 : juce::jmin(startSample, numSamples), std::memory_order_relaxed);
+    }
+
+    size_t StreamingSamples::getSizeInBytes() const noexcept
+    {
+        return (size_t)numChannels * ((size_t)capacity + (size_t)pinned.getNumSamples()) * sizeof(float);
+    }
+
+    //==============================================================================
+    int StreamingSamples::useTimeSlice()
+    {
+        // Pins are small and only change when a cue does, so they go ahead of the ring
+        return fillNextPin() || fillNextChunk() ? 0 : 5;
+    }
+
+    bool StreamingSamples::fillNextPin()
+    {
+        for (size_t slot = 0; slot < pins.size(); ++slot)
+        {
+            auto& pin = pins[slot];
+            const auto requested = pin.requested.load(std::memory_order_relaxed);
+
+            if (requested == pin.loaded)
+                continue;
+
+            // Empty the range before moving the generation on, so a reader that sees the
+            // new generation also sees the empty range
+            pin.validStart = std::numeric_limits<juce::int64>::max();
+            pin.generation.fetch_add(1, std::memory_order_acq_rel);
+            pin.loaded = requested;
+
+            if (requested >= 0)
+            {
+                const auto first = juce::jmax((juce::int64)0, requested - pinnedBefore);
+                const auto num = (int)juce::jmin((juce::int64)pinLength, numSamples - first);
+
+                reader->read(&pinned, (int)slot * pinLength, num, first, true, true);
+
+                pin.validEnd.store(first + num, std::memory_order_release);
+                pin.validStart.store(first, std::memory_order_release);
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool StreamingSamples::fillNextChunk()
+    {
+        const auto target = juce::jlimit((juce::int64)0, numSamples, requestedPosition.load(std::memory_order_relaxed));
+        const bool backwards = requestedBackwards.load(std::memory_order_relaxed);
+
+        auto start = validStart.load();
+        auto end = validEnd.load();
+
+        auto startNewEpoch = [this]
+        {
+            epoch.fetch_add(1, std::memory_order_acq_rel);
+            trimmedStart = false;
+            trimmedEnd = false;
+        };
+
+        // The playhead has left the window, so start a new one where it landed
+        if (target < start || target > end)
+        {
+            startNewEpoch();
+
+            // Keep the range empty while both ends move
+            validStart = std::numeric_limits<juce::int64>::max();
+            validEnd = target;
+            validStart = target;
+            start = end = target;
+        }
+
+        // Grows the range forwards, trimming the start if the ring is full
+        auto growEnd = [&](juce::int64 num)
+        {
+            if (trimmedEnd)
+                startNewEpoch();
+
+            if (end + num - capacity > start)
+            {
+                validStart = end + num - capacity;
+                trimmedStart = true;
+            }
+
+            std::atomic_thread_fence(std::memory_order_release);
+            readIntoRing(end, (int)num);
+            validEnd.store(end + num, std::memory_order_release);
+        };
+
+        // Grows the range backwards, trimming the end if the ring is full
+        auto growStart = [&](juce::int64 num)
+        {
+            if (trimmedStart)
+                startNewEpoch();
+
+            if (end - (start - num) > capacity)
+            {
+                validEnd = start - num + capacity;
+                trimmedEnd = true;
+            }
+
+            std::atomic_thread_fence(std::memory_order_release);
+            readIntoRing(start - num, (int)num);
+            validStart.store(start - num, std::memory_order_release);
+        };
+
+        // Fill the look-ahead first, then whatever room is left behind the playhead
+        const auto room = capacity - (end - start);
+
+        if (!backwards)
+        {
+            const auto aheadLimit = juce::jmin(numSamples, target + lookAhead);
+            const auto behindLimit = juce::jmax((juce::int64)0, target - lookAhead);
+
+            if (end < aheadLimit)
+                growEnd(juce::jmin((juce::int64)chunkSize, aheadLimit - end));
+            else if (start > behindLimit && room > 0)
+                growStart(juce::jmin((juce::int64)chunkSize, start - behindLimit, room));
+            else
+                return false;
+        }
+        else
+        {
+            const auto aheadLimit = juce::jmax((juce::int64)0, target - lookAhead);
+            const auto behindLimit = juce::jmin(numSamples, target + lookAhead);
+
+            if (start > aheadLimit)
+                growStart(juce::jmin((juce::int64)chunkSize, start - aheadLimit));
+            else if (end < behindLimit && room > 0)
+                growEnd(juce::jmin((juce::int64)chunkSize, behindLimit - end, room));
+            else
+                return false;
+        }
+
+        return true;
+    }
+
+    void StreamingSamples::readIntoRing(juce::int64 fileStart, int numToRead)
+    {
+        const int ringIndex = (int)(fileStart % capacity);
+        const int firstPart = juce::jmin(numToRead, (int)capacity - ringIndex);
+
+        reader->read(&ring, ringIndex, firstPart, fileStart, true, true);
+
+        if (firstPart < numToRead)
+            reader->read(&ring, 0, numToRead - firstPart, fileStart + firstPart, true, true);
+    }
+}
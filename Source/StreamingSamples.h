@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    StreamingSamples.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TrackSamples.h"
+
+namespace OtoDecksAudio
+{
+    // Plays a track straight from disk for files too long to decode into memory.
+    // A read-ahead thread keeps a window of the file around the playhead decoded
+    // into a ring buffer. The audio thread reads from the ring without locking.
+    //
+    // The window covers the look-ahead in the direction of play and about as much
+    // again behind it, so seeks and scratches inside it are instant. Reads outside
+    // it fail, and the playhead reports that as buffering until the window catches up,
+    // except around pinned positions, whose first couple of seconds are held in a
+    // buffer of their own for as long as they stay pinned.
+    class StreamingSamples : public TrackSamples,
+                             private juce::TimeSliceClient
+    {
+    public:
+        // Takes ownership of the reader. Fills the first look-ahead window before
+        // returning, so playback from the top can start straight away.
+        StreamingSamples(std::unique_ptr<juce::AudioFormatReader> readerToUse,
+                         double lookAheadSeconds,
+                         juce::TimeSliceThread& readAheadThread);
+        ~StreamingSamples() override;
+
+        int getNumChannels() const noexcept override { return numChannels; }
+        juce::int64 getNumSamples() const noexcept override { return numSamples; }
+
+        bool read(int channel, juce::int64 startSample, float* dest, int numToRead, float gain = 1.0f) const override;
+        bool addTo(int channel, juce::int64 startSample, float* dest, int numToRead, float gain = 1.0f) const override;
+        bool isAvailable(juce::int64 startSample, juce::int64 endSample) const noexcept override;
+        void setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept override;
+        void pinRegion(int slot, juce::int64 startSample) override;
+        size_t getSizeInBytes() const noexcept override;
+
+    private:
+        bool readFromRing(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const;
+        bool readFromPins(int channel, juce::int64 startSample, float* dest, int numToRead, float gain) const;
+        bool isInRing(juce::int64 startSample, juce::int64 endSample) const noexcept;
+
+        // Read-ahead thread. Does one chunk of work and returns true if there is more to do.
+        bool fillNextChunk();
+        bool fillNextPin();
+        void readIntoRing(juce::int64 fileStart, int numToRead);
+        int useTimeSlice() override;
+
+        static constexpr int chunkSize = 1 << 14;
+
+        // How much of the track each pin holds: enough before it for the resampler and
+        // key lock to reach back, and enough after for the ring to catch up
+        static constexpr double pinnedSeconds = 2.0;
+        static constexpr int pinnedBefore = 4096;
+
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        juce::TimeSliceThread& thread;
+
+        const int numChannels;
+        const juce::int64 numSamples;
+        const juce::int64 lookAhead;
+
+        // Frame n of the file lives at ring index n % capacity
+        juce::AudioBuffer<float> ring;
+        const juce::int64 capacity;
+
+        // The file range currently held in the ring. The read-ahead thread shrinks it
+        // before overwriting anything, so a reader that still finds its run inside it
+        // after copying knows the copy is intact. The epoch changes whenever the range
+        // jumps or turns round, which covers every case where that check isn't enough.
+        std::atomic<juce::int64> validStart { 0 };
+        std::atomic<juce::int64> validEnd { 0 };
+        std::atomic<juce::uint32> epoch { 0 };
+
+        // Where the audio thread says playback is heading
+        std::atomic<juce::int64> requestedPosition { 0 };
+        std::atomic<bool> requestedBackwards { false };
+
+        // Read-ahead thread only: which ends of the range have been trimmed this epoch
+        bool trimmedStart = false;
+        bool trimmedEnd = false;
+
+        // Pinned audio, one stretch of pinLength per slot. Each slot's range works like
+        // the ring's: it is emptied and its generation moved on before it is refilled.
+        struct Pin
+        {
+            std::atomic<juce::int64> requested { -1 };
+            std::atomic<juce::int64> validStart { std::numeric_limits<juce::int64>::max() };
+            std::atomic<juce::int64> validEnd { 0 };
+            std::atomic<juce::uint32> generation { 0 };
+
+            // Read-ahead thread only
+            juce::int64 loaded = -1;
+        };
+
+        const int pinLength;
+        juce::AudioBuffer<float> pinned;
+        std::array<Pin, maxPinnedRegions> pins;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingSamples)
+    };
+}
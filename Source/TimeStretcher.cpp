@@ -0,0 +1,257 @@
+/*
+  ==============================================================================
+
+    TimeStretcher.cpp
+
+  ==============================================================================
+*/
+
+#include "TimeStretcher.h"
+#include "Resampler.h"
+
+namespace OtoDecksAudio
+{
+    namespace
+    {
+        // Grains of about 40ms keep drums tight while still holding a bass note's pitch
+        constexpr double grainSeconds = 0.04;
+
+        inline float dotProduct(const float* a, const float* b, int numSamples) noexcept
+        {
+            // Four running sums so the compiler can keep them in one vector register
+            float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+            int i = 0;
+
+            for (; i + 4 <= numSamples; i += 4)
+            {
+                sum0 += a[i] * b[i];
+                sum1 += a[i + 1] * b[i + 1];
+                sum2 += a[i + 2] * b[i + 2];
+                sum3 += a[i + 3] * b[i + 3];
+            }
+
+            for (; i < numSamples; ++i)
+                sum0 += a[i] * b[i];
+
+            return (sum0 + sum1) + (sum2 + sum3);
+        }
+    }
+
+    void TimeStretcher::prepare(double sampleRate, int maxChannels)
+    {
+        // Multiples of eight keep the hop and search radius on the coarse search grid
+        frameSize = juce::jmax(256, juce::roundToInt(sampleRate * grainSeconds / 8.0) * 8);
+        hopSize = frameSize / 2;
+        searchRadius = hopSize / 2 / decimation * decimation;
+        grainChannels = juce::jmax(1, maxChannels);
+        activeChannels = grainChannels;
+
+        // A periodic Hann window adds up to exactly one at half-grain overlaps
+        window.resize((size_t)frameSize);
+        for (int i = 0; i < frameSize; ++i)
+            window[(size_t)i] = (float)(0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * i / frameSize));
+
+        const int candidateLength = frameSize + 2 * searchRadius;
+        candidates.setSize(grainChannels, candidateLength);
+        previous.setSize(grainChannels, frameSize);
+        ready.setSize(grainChannels, hopSize);
+
+        referenceMono.resize((size_t)hopSize);
+        candidateMono.resize((size_t)candidateLength);
+        coarseReference.resize((size_t)(hopSize / decimation));
+        coarseCandidate.resize((size_t)(candidateLength / decimation));
+        scratch.resize((size_t)(std::ceil(candidateLength * maxSampleRateRatio) + 8));
+
+        reset();
+    }
+
+    void TimeStretcher::reset() noexcept
+    {
+        hasPrevious = false;
+        readyPosition = hopSize;
+    }
+
+    double TimeStretcher::getReach(double sampleRateRatio) const noexcept
+    {
+        return (frameSize + 2 * searchRadius + hopSize + 4) * sampleRateRatio;
+    }
+
+    //==============================================================================
+    void TimeStretcher::process(const TrackSamples& source, double sampleRateRatio, juce::AudioBuffer<float>& output,
+                                int startSample, int numSamples, double position, double increment, double incrementStep) noexcept
+    {
+        const int numChannels = juce::jmin(source.getNumChannels(), grainChannels);
+
+        if (numChannels != activeChannels)
+        {
+            activeChannels = numChannels;
+            reset();
+        }
+
+        for (int done = 0; done < numSamples;)
+        {
+            if (readyPosition >= hopSize)
+            {
+                // Each grain starts wherever the playhead has reached by the time it's needed,
+                // so the tempo follows the playhead exactly and never drifts
+                const double nominal = position + increment * done + incrementStep * done * (done - 1) * 0.5;
+                const bool backwards = increment + incrementStep * done < 0.0;
+
+                makeNextGrain(source, nominal, backwards ? -sampleRateRatio : sampleRateRatio);
+                readyPosition = 0;
+            }
+
+            const int numToCopy = juce::jmin(hopSize - readyPosition, numSamples - done);
+
+            for (int channel = 0; channel < output.getNumChannels(); ++channel)
+                juce::FloatVectorOperations::copy(output.getWritePointer(channel, startSample + done),
+                                                  ready.getReadPointer(channel % numChannels, readyPosition), numToCopy);
+
+            readyPosition += numToCopy;
+            done += numToCopy;
+        }
+    }
+
+    void TimeStretcher::makeNextGrain(const TrackSamples& source, double nominalPosition, double step) noexcept
+    {
+        // Starting fresh, lay down the grain that would have come just before, so the
+        // first output crossfades like any other instead of fading in from silence
+        if (!hasPrevious)
+        {
+            for (int channel = 0; channel < activeChannels; ++channel)
+                readGrain(source, channel, nominalPosition - step * hopSize, step, previous.getWritePointer(channel), frameSize);
+
+            hasPrevious = true;
+        }
+
+        const int candidateLength = frameSize + 2 * searchRadius;
+
+        for (int channel = 0; channel < activeChannels; ++channel)
+            readGrain(source, channel, nominalPosition - step * searchRadius, step, candidates.getWritePointer(channel), candidateLength);
+
+        const int offset = findBestOffset();
+        const float* fadeIn = window.data();
+        const float* fadeOut = window.data() + hopSize;
+
+        for (int channel = 0; channel < activeChannels; ++channel)
+        {
+            const float* grain = candidates.getReadPointer(channel, offset);
+            const float* tail = previous.getReadPointer(channel, hopSize);
+            float* out = ready.getWritePointer(channel);
+
+            for (int i = 0; i < hopSize; ++i)
+                out[i] = tail[i] * fadeOut[i] + grain[i] * fadeIn[i];
+
+            juce::FloatVectorOperations::copy(previous.getWritePointer(channel), grain, frameSize);
+        }
+    }
+
+    int TimeStretcher::findBestOffset() noexcept
+    {
+        // Compare the candidates against what the last grain would have gone on to play,
+        // on a mono mix so every channel lands on the same offset
+        const int candidateLength = frameSize + 2 * searchRadius;
+
+        juce::FloatVectorOperations::copy(referenceMono.data(), previous.getReadPointer(0, hopSize), hopSize);
+        juce::FloatVectorOperations::copy(candidateMono.data(), candidates.getReadPointer(0), candidateLength);
+
+        for (int channel = 1; channel < activeChannels; ++channel)
+        {
+            juce::FloatVectorOperations::add(referenceMono.data(), previous.getReadPointer(channel, hopSize), hopSize);
+            juce::FloatVectorOperations::add(candidateMono.data(), candidates.getReadPointer(channel), candidateLength);
+        }
+
+        // Coarse pass on every fourth sample and offset
+        const int coarseLength = hopSize / decimation;
+        const int coarseCandidates = candidateLength / decimation;
+
+        for (int i = 0; i < coarseLength; ++i)
+            coarseReference[(size_t)i] = referenceMono[(size_t)(i * decimation)];
+
+        for (int i = 0; i < coarseCandidates; ++i)
+            coarseCandidate[(size_t)i] = candidateMono[(size_t)(i * decimation)];
+
+        double energy = 0.0;
+        for (int i = 0; i < coarseLength; ++i)
+            energy += (double)coarseCandidate[(size_t)i] * coarseCandidate[(size_t)i];
+
+        int best = searchRadius;
+        double bestScore = -std::numeric_limits<double>::max();
+
+        for (int coarse = 0; coarse <= 2 * searchRadius / decimation; ++coarse)
+        {
+            const double correlation = dotProduct(coarseReference.data(), coarseCandidate.data() + coarse, coarseLength);
+            const double score = correlation / std::sqrt(juce::jmax(energy, 1.0e-9));
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                best = coarse * decimation;
+            }
+
+            const float entering = coarseCandidate[(size_t)(coarse + coarseLength)];
+            const float leaving = coarseCandidate[(size_t)coarse];
+            energy += (double)entering * entering - (double)leaving * leaving;
+        }
+
+        // Fine pass at full rate either side of the coarse winner
+        const int coarseBest = best;
+        bestScore = -std::numeric_limits<double>::max();
+
+        for (int offset = juce::jmax(0, coarseBest - decimation + 1); offset <= juce::jmin(2 * searchRadius, coarseBest + decimation - 1); ++offset)
+        {
+            const float* candidate = candidateMono.data() + offset;
+            const double correlation = dotProduct(referenceMono.data(), candidate, hopSize);
+            const double score = correlation / std::sqrt(juce::jmax((double)dotProduct(candidate, candidate, hopSize), 1.0e-9));
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                best = offset;
+            }
+        }
+
+        return best;
+    }
+
+    void TimeStretcher::readGrain(const TrackSamples& source, int channel, double start, double step, float* dest, int numSamples) noexcept
+    {
+        if (std::abs(step) == 1.0 && start == std::floor(start))
+        {
+            const auto first = step > 0.0 ? (juce::int64)start : (juce::int64)start - numSamples + 1;
+            readClipped(source, channel, first, dest, numSamples);
+
+            if (step < 0.0)
+                std::reverse(dest, dest + numSamples);
+
+            return;
+        }
+
+        // Off the sample grid, or with the file at a different rate to the device, the
+        // grain is resampled from the stretch of source it covers
+        const double end = start + step * (numSamples - 1);
+        const auto first = (juce::int64)std::floor(juce::jmin(start, end)) - 1;
+        const int length = (int)((juce::int64)std::floor(juce::jmax(start, end)) + 3 - first);
+
+        readClipped(source, channel, first, scratch.data(), length);
+        Resampler::process(Resampler::Quality::Cubic, scratch.data(), dest, numSamples, start - (double)first, step, 0.0);
+    }
+
+    void TimeStretcher::readClipped(const TrackSamples& source, int channel, juce::int64 first, float* dest, int numSamples) const noexcept
+    {
+        // Anything before the start or after the end of the track reads as silence
+        const juce::int64 numFrames = source.getNumSamples();
+        const juce::int64 readStart = juce::jlimit((juce::int64)0, numFrames, first);
+        const juce::int64 readEnd = juce::jlimit((juce::int64)0, numFrames, first + numSamples);
+
+        if (readEnd <= readStart)
+        {
+            juce::FloatVectorOperations::clear(dest, numSamples);
+            return;
+        }
+
+        juce::FloatVectorOperations::clear(dest, (int)(readStart - first));
+        source.read(channel, readStart, dest + (readStart - first), (int)(readEnd - readStart));
+        juce::FloatVectorOperations::clear(dest + (readEnd - first), (int)(first + numSamples - readEnd));
+    }
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    TimeStretcher.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "TrackSamples.h"
+
+namespace OtoDecksAudio
+{
+    // Plays a track at any tempo without changing its pitch, using WSOLA: short
+    // windowed grains are read at normal speed from wherever the playhead has got to,
+    // and overlap-added half a grain apart. Each new grain is nudged by up to a
+    // quarter of a grain to where it best lines up with the one it fades in over,
+    // which keeps the waveform continuous and stops the phasing of plain overlap-add.
+    //
+    // Grains are read straight from the track, so nothing has to be buffered up
+    // before the first output. The cost is the same for every grain whatever the
+    // tempo, and prepare allocates everything processing needs.
+    class TimeStretcher
+    {
+    public:
+        // Fastest the source can run against the device rate, as grains are read resampled
+        static constexpr double maxSampleRateRatio = 8.0;
+
+        TimeStretcher() = default;
+
+        // Sizes the grains for the device rate and allocates the working buffers
+        void prepare(double sampleRate, int maxChannels);
+
+        // Audio thread only. Forgets the last grain, so the next one starts fresh from
+        // wherever the playhead is. Call after a seek or any break in stretched playback.
+        void reset() noexcept;
+
+        // How far what is heard can be from the playhead, in output samples
+        int getLatencyInSamples() const noexcept { return hopSize; }
+
+        // How far either side of the playhead, in source samples, grains may read
+        double getReach(double sampleRateRatio) const noexcept;
+
+        // Audio thread only. Writes numSamples outputs for a playhead that starts at
+        // position and moves by increment, which changes by incrementStep after every
+        // output. The increment must not change sign within the block.
+        void process(const TrackSamples& source, double sampleRateRatio, juce::AudioBuffer<float>& output,
+                     int startSample, int numSamples, double position, double increment, double incrementStep) noexcept;
+
+    private:
+        void makeNextGrain(const TrackSamples& source, double nominalPosition, double step) noexcept;
+        int findBestOffset() noexcept;
+        void readGrain(const TrackSamples& source, int channel, double start, double step, float* dest, int numSamples) noexcept;
+        void readClipped(const TrackSamples& source, int channel, juce::int64 first, float* dest, int numSamples) const noexcept;
+
+        // The coarse search compares every fourth sample at every fourth offset
+        static constexpr int decimation = 4;
+
+        int frameSize = 0;
+        int hopSize = 0;
+        int searchRadius = 0;
+        int grainChannels = 0;
+        int activeChannels = 0;
+
+        std::vector<float> window;
+
+        // Every candidate grain start within the search range, back to back
+        juce::AudioBuffer<float> candidates;
+
+        // The last grain, whose second half the next one fades in over
+        juce::AudioBuffer<float> previous;
+        bool hasPrevious = false;
+
+        // Finished output waiting to be played
+        juce::AudioBuffer<float> ready;
+        int readyPosition = 0;
+
+        // Mono mixes for the alignment search, and source audio for resampled reads
+        std::vector<float> referenceMono, candidateMono;
+        std::vector<float> coarseReference, coarseCandidate;
+        std::vector<float> scratch;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimeStretcher)
+    };
+}
@@ -356,6 +356,17 @@ void TrackListComponent::updateTimer(double time)
     timerLabel.setText(timeAsString, juce::NotificationType::dontSendNotification);
 }
 
+void TrackListComponent::showLoadProgress(float progress)
+{
+    juce::String progressAsString = "Loading " + juce::String(juce::roundToInt(progress * 100.0f)) + "%";
+    timerLabel.setText(progressAsString, juce::NotificationType::dontSendNotification);
+}
+
+void TrackListComponent::showBuffering()
+{
+    timerLabel.setText("Buffering", juce::NotificationType::dontSendNotification);
+}
+
 // Takes a double time and returns it as a formatted string for timer
 juce::String TrackListComponent::convertSecondsToTimer(double time)
 {
@@ -48,6 +48,12 @@ public:
     // Update Track Time
     void updateTimer(double time);
 
+    // Shows the decode progress of a track that is still loading
+    void showLoadProgress(float progress);
+
+    // Shows that a streamed track is waiting for audio after a seek
+    void showBuffering();
+
     // Takes a double time and returns it as a formatted string for timer
     static juce::String convertSecondsToTimer(double time);
 
@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    TrackLoader.cpp
+
+  ==============================================================================
+*/
+
+#include "TrackLoader.h"
+
+class TrackLoader::DecodeJob : public juce::ThreadPoolJob
+{
+public:
+    DecodeJob(TrackLoader& _owner, juce::URL _audioURL, OtoDecksAudio::SampleStorage::Format _format,
+              double _targetSampleRate, int _generation)
+        : ThreadPoolJob("TrackLoader::DecodeJob"),
+          owner(_owner),
+          audioURL(std::move(_audioURL)),
+          format(_format),
+          targetSampleRate(_targetSampleRate),
+          generation(_generation)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto track = std::make_unique<LoadedTrack>();
+
+        // Uncompressed local files play straight from a memory map, with nothing to decode
+        if (audioURL.isLocalFile())
+        {
+            if (auto mapped = OtoDecksAudio::MappedSamples::create(owner.formatManager, audioURL.getLocalFile(),
+                                                                   owner.streamingLookAhead.load(), owner.readAheadThread))
+            {
+                track->sampleRate = mapped->getSampleRate();
+                track->samples = std::move(mapped);
+            }
+        }
+
+        // Then a track another deck has decoded, or that was played recently
+        if (track->samples == nullptr && audioURL.isLocalFile())
+        {
+            if (auto cached = owner.trackCache.find(audioURL.getLocalFile(), format, targetSampleRate))
+            {
+                track->sampleRate = cached->getSampleRate();
+                track->samples = std::move(cached);
+            }
+        }
+
+        if (track->samples == nullptr)
+        {
+            juce::URL::InputStreamOptions options((juce::URL::ParameterHandling)0);
+            std::unique_ptr<juce::AudioFormatReader> reader(owner.formatManager.createReaderFor(audioURL.createInputStream(options)));
+
+            if (reader == nullptr)
+            {
+                owner.finishLoad(generation, nullptr);
+                return jobHasFinished;
+            }
+
+            // Converting to the device rate changes how many samples there are to hold
+            const double storedRate = targetSampleRate > 0.0 ? targetSampleRate : reader->sampleRate;
+            const auto decodedSize = (juce::int64)((double)OtoDecksAudio::SampleStorage::getBytesPerSample(format)
+                                                     * reader->numChannels * reader->lengthInSamples * storedRate / reader->sampleRate);
+
+            if (decodedSize > owner.memoryBudget.load())
+            {
+                // Too big to hold in memory: keep the reader open and stream from it instead
+                track->sampleRate = reader->sampleRate;
+                track->samples.reset(new OtoDecksAudio::StreamingSamples(std::move(reader),
+                                                                         owner.streamingLookAhead.load(),
+                                                                         owner.readAheadThread));
+            }
+            else if (auto decoded = decodeStartOf(std::move(reader)))
+            {
+                if (audioURL.isLocalFile())
+                    owner.trackCache.add(audioURL.getLocalFile(), format, targetSampleRate, decoded);
+
+                track->sampleRate = decoded->getSampleRate();
+                track->samples = std::move(decoded);
+            }
+        }
+
+        if (track->samples == nullptr || shouldExit())
+            return jobHasFinished;
+
+        // Both directions play from the track's samples, so nothing else needs the reader after this point
+        track->memorySource.reset(new OtoDecksAudio::MemoryAudioSource(*track->samples, false));
+
+        owner.finishLoad(generation, std::move(track));
+        return jobHasFinished;
+    }
+
+private:
+    // Decodes just enough of the track to start playing it, and leaves the rest to the
+    // read-ahead thread. Returns nullptr if the job was asked to stop part way through.
+    std::shared_ptr<OtoDecksAudio::ProgressiveSamples> decodeStartOf(std::unique_ptr<juce::AudioFormatReader> reader)
+    {
+        auto samples = std::make_shared<OtoDecksAudio::ProgressiveSamples>(std::move(reader), format, targetSampleRate,
+                                                                           &owner.trackCache.getConversionPool());
+        const auto numSamplesToPlay = juce::jmin(samples->getNumSamples(), (juce::int64)(samples->getSampleRate() * playableAfterSeconds));
+
+        while (samples->getDecodedFrontier() < numSamplesToPlay)
+        {
+            if (shouldExit() || !samples->decodeNextChunk())
+                break;
+
+            owner.setProgress(generation, (float)samples->getDecodedFrontier() / (float)numSamplesToPlay);
+        }
+
+        if (shouldExit())
+            return nullptr;
+
+        samples->startDecodingInBackground(owner.trackCache.getDecodeThread());
+        return samples;
+    }
+
+    // How much of a track is decoded before it is handed to the deck
+    static constexpr double playableAfterSeconds = 1.0;
+
+    TrackLoader& owner;
+    juce::URL audioURL;
+    OtoDecksAudio::SampleStorage::Format format;
+    double targetSampleRate;
+    int generation;
+};
+
+//==============================================================================
+TrackLoader::TrackLoader(juce::AudioFormatManager& _formatManager, DecodedTrackCache& _trackCache)
+    : formatManager(_formatManager),
+      trackCache(_trackCache)
+{
+    readAheadThread.startThread();
+}
+
+TrackLoader::~TrackLoader()
+{
+    cancelPendingUpdate();
+    loaderPool.removeAllJobs(true, 4000);
+}
+
+void TrackLoader::setStreamingPolicy(juce::int64 memoryBudgetBytes, double lookAheadSeconds) noexcept
+{
+    memoryBudget = memoryBudgetBytes;
+    streamingLookAhead = lookAheadSeconds;
+}
+
+void TrackLoader::load(const juce::URL& audioURL)
+{
+    // Ask the running job to stop; its result is ignored anyway once the generation moves on
+    loaderPool.removeAllJobs(true, 0);
+
+    const int generation = ++currentGeneration;
+
+    {
+        const juce::ScopedLock sl(resultLock);
+        finishedTrack.reset();
+        hasFinishedLoad = false;
+    }
+
+    progress = 0.0f;
+    state = State::Loading;
+
+    loaderPool.addJob(new DecodeJob(*this, audioURL, storageFormat.load(), deviceSampleRate.load(), generation), true);
+}
+
+void TrackLoader::setProgress(int generation, float newProgress)
+{
+    if (generation == currentGeneration.load())
+        progress = newProgress;
+}
+
+void TrackLoader::finishLoad(int generation, std::unique_ptr<LoadedTrack> track)
+{
+    {
+        const juce::ScopedLock sl(resultLock);
+
+        // A newer load was started in the meantime, drop this one
+        if (generation != currentGeneration.load())
+            return;
+
+        finishedTrack = std::move(track);
+        hasFinishedLoad = true;
+    }
+
+    triggerAsyncUpdate();
+}
+
+void TrackLoader::handleAsyncUpdate()
+{
+    std::unique_ptr<LoadedTrack> track;
+
+    {
+        const juce::ScopedLock sl(resultLock);
+
+        if (!hasFinishedLoad)
+            return;
+
+        track = std::move(finishedTrack);
+        hasFinishedLoad = false;
+    }
+
+    if (track == nullptr)
+    {
+        DBG("Something went wrong loading the file");
+        state = State::Failed;
+        return;
+    }
+
+    progress = 1.0f;
+    state = State::Ready;
+
+    if (onTrackLoaded)
+        onTrackLoaded(std::move(track));
+}
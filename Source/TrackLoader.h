@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    TrackLoader.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "MemoryAudioSource.h"
+#include "SampleStorage.h"
+#include "StreamingSamples.h"
+#include "MappedSamples.h"
+#include "ProgressiveSamples.h"
+#include "DecodedTrackCache.h"
+
+// One loaded track. It is built entirely on the loader thread, so the deck only
+// has to swap a pointer to start playing it.
+struct LoadedTrack
+{
+    LoadedTrack() = default;
+
+    // Mapped straight from an uncompressed file, or else decoded into memory while it
+    // plays or streamed from disk, depending on the memory budget. Decoded samples may
+    // be shared with the other deck through the cache.
+    std::shared_ptr<OtoDecksAudio::TrackSamples> samples;
+
+    // Unity-rate cursor over samples, used by DeckPlayhead when no interpolation is needed
+    std::unique_ptr<OtoDecksAudio::MemoryAudioSource> memorySource;
+
+    double sampleRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE (LoadedTrack)
+};
+
+// Opens tracks on a background thread so the message thread never blocks on file IO.
+// Tracks are delivered back on the message thread as soon as they can be played.
+class TrackLoader : private juce::AsyncUpdater
+{
+public:
+    enum class State { Empty, Loading, Ready, Failed };
+
+    TrackLoader(juce::AudioFormatManager& _formatManager, DecodedTrackCache& _trackCache);
+    ~TrackLoader() override;
+
+    // Starts decoding the URL, abandoning any load that is still running
+    void load(const juce::URL& audioURL);
+
+    // Sample format that tracks are kept in once decoded. Takes effect from the next load.
+    void setStorageFormat(OtoDecksAudio::SampleStorage::Format newFormat) noexcept { storageFormat = newFormat; }
+    OtoDecksAudio::SampleStorage::Format getStorageFormat() const noexcept { return storageFormat.load(); }
+
+    // Tracks that would take more than this many bytes to decode into memory are
+    // streamed from disk instead, keeping lookAheadSeconds decoded ahead of the playhead.
+    // Takes effect from the next load.
+    void setStreamingPolicy(juce::int64 memoryBudgetBytes, double lookAheadSeconds) noexcept;
+
+    // Tracks decoded into memory are converted to this rate as they decode, so the deck
+    // doesn't have to convert while playing. Streamed and mapped tracks keep their own
+    // rate. Zero leaves every track at its own rate. Takes effect from the next load.
+    void setDeviceSampleRate(double newSampleRate) noexcept { deviceSampleRate = newSampleRate; }
+
+    State getState() const noexcept { return state.load(); }
+    bool isLoading() const noexcept { return getState() == State::Loading; }
+
+    // Progress of the current load towards being playable, from 0 to 1
+    float getProgress() const noexcept { return progress.load(); }
+
+    // Called on the message thread with each successfully decoded track
+    std::function<void(std::unique_ptr<LoadedTrack>)> onTrackLoaded;
+
+private:
+    class DecodeJob;
+
+    void setProgress(int generation, float newProgress);
+    void finishLoad(int generation, std::unique_ptr<LoadedTrack> track);
+    void handleAsyncUpdate() override;
+
+    juce::AudioFormatManager& formatManager;
+    DecodedTrackCache& trackCache;
+
+    std::atomic<OtoDecksAudio::SampleStorage::Format> storageFormat { OtoDecksAudio::SampleStorage::Format::Float32 };
+    std::atomic<juce::int64> memoryBudget { 256 * 1024 * 1024 };
+    std::atomic<double> streamingLookAhead { 10.0 };
+    std::atomic<double> deviceSampleRate { 0.0 };
+    std::atomic<State> state { State::Empty };
+    std::atomic<float> progress { 0.0f };
+    std::atomic<int> currentGeneration { 0 };
+
+    // Keeps streamed and mapped tracks ahead of the playhead. Declared before anything that can hold a track.
+    juce::TimeSliceThread readAheadThread { "Track read-ahead" };
+
+    juce::CriticalSection resultLock;
+    std::unique_ptr<LoadedTrack> finishedTrack;
+    bool hasFinishedLoad = false;
+
+    // Declared last so it is destroyed (and its job stopped) before anything the job touches
+    juce::ThreadPool loaderPool { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TrackLoader)
+};
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    TrackSamples.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // Where a deck's audio comes from: decoded into memory, or streamed from disk.
+    // The playhead only ever asks for runs of float samples, so it doesn't need to
+    // know which. Positions are 64-bit so very long recordings can be addressed.
+    class TrackSamples
+    {
+    public:
+        virtual ~TrackSamples() = default;
+
+        virtual int getNumChannels() const noexcept = 0;
+        virtual juce::int64 getNumSamples() const noexcept = 0;
+
+        // Audio thread. Converts a run of samples to float, scaled by gain. Returns false
+        // if any of the run isn't available yet, in which case the run reads as silence.
+        virtual bool read(int channel, juce::int64 startSample, float* dest, int numSamples, float gain = 1.0f) const = 0;
+
+        // Like read, but adds into dest instead of overwriting it. Missing runs add nothing.
+        virtual bool addTo(int channel, juce::int64 startSample, float* dest, int numSamples, float gain = 1.0f) const = 0;
+
+        // True if every sample in [startSample, endSample) can be read right now
+        virtual bool isAvailable(juce::int64 startSample, juce::int64 endSample) const noexcept
+        {
+            juce::ignoreUnused(startSample, endSample);
+            return true;
+        }
+
+        // Audio thread. Tells sources that fetch audio in the background where playback
+        // is and which way it is heading, so they can fetch what will be needed next.
+        // The playhead says which deck is asking, for sources that decks share.
+        virtual void setPlaybackPosition(int playhead, juce::int64 position, bool backwards) noexcept
+        {
+            juce::ignoreUnused(playhead, position, backwards);
+        }
+
+        // Sources that fetch audio in the background keep a little audio from each pinned
+        // position on hand whatever the playhead does, so a jump to a hot cue never waits
+        // on disk. Message thread. A position of -1 releases the slot.
+        static constexpr int maxPinnedRegions = 8;
+
+        virtual void pinRegion(int slot, juce::int64 startSample)
+        {
+            juce::ignoreUnused(slot, startSample);
+        }
+
+        // Bytes of memory held for sample data
+        virtual size_t getSizeInBytes() const noexcept = 0;
+    };
+}
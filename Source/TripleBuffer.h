@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+namespace OtoDecksAudio
+{
+    // Hands the latest copy of a value from one thread to another without either side
+    // ever waiting. The writer fills a slot of its own and swaps it into the middle; the
+    // reader swaps the middle out whenever something new has arrived. Values the reader
+    // never got round to are simply skipped.
+    //
+    // Only one thread may write and only one may read, though they can be different.
+    template <typename Value>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() = default;
+
+        // Writer thread only
+        void write(const Value& newValue) noexcept
+        {
+            slots[backIndex] = newValue;
+            backIndex = shared.exchange(backIndex | freshFlag, std::memory_order_acq_rel) & indexMask;
+        }
+
+        // Reader thread only. The newest value written, or the last one read if nothing has changed.
+        const Value& read() noexcept
+        {
+            if ((shared.load(std::memory_order_relaxed) & freshFlag) != 0)
+                frontIndex = shared.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+
+            return slots[frontIndex];
+        }
+
+    private:
+        static constexpr int indexMask = 3;
+        static constexpr int freshFlag = 4;
+
+        Value slots[3] {};
+        std::atomic<int> shared { 1 };
+        int backIndex = 0;
+        int frontIndex = 2;
+
+        JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+    };
+}